@@ -25,8 +25,26 @@
 //#define AES192 1
 //#define AES256 1
 
+#define AES_BLOCKLEN 16 // Block length in bytes - AES is 128b block only
+#define AES_KEYLEN 16   // Key length in bytes
+#define AES_keyExpSize 176
+
+// The expanded round keys of a key. Expand once with AES_init_ctx and reuse for every block,
+// the functions taking a ctx never modify it and can be called from several tasks at once.
+struct AES_ctx
+{
+  uint8_t RoundKey[AES_keyExpSize];
+};
+
+void AES_init_ctx(struct AES_ctx* ctx, const uint8_t* key);
+
 #if defined(ECB) && (ECB == 1)
 
+// Encrypt/decrypt a single block in place.
+void AES_ECB_encrypt(const struct AES_ctx* ctx, uint8_t* buf);
+void AES_ECB_decrypt(const struct AES_ctx* ctx, uint8_t* buf);
+
+// Expands the key on every call, prefer the ctx versions when a key is used more than once.
 void AES_ECB_encrypt(const uint8_t* input, const uint8_t* key, uint8_t *output, const uint32_t length);
 void AES_ECB_decrypt(const uint8_t* input, const uint8_t* key, uint8_t *output, const uint32_t length);
 
@@ -35,6 +53,10 @@ void AES_ECB_decrypt(const uint8_t* input, const uint8_t* key, uint8_t *output,
 
 #if defined(CBC) && (CBC == 1)
 
+// length must be a multiple of AES_BLOCKLEN, iv is not modified and output must not overlap input.
+void AES_CBC_encrypt_buffer(const struct AES_ctx* ctx, uint8_t* output, const uint8_t* input, uint32_t length, const uint8_t* iv);
+void AES_CBC_decrypt_buffer(const struct AES_ctx* ctx, uint8_t* output, const uint8_t* input, uint32_t length, const uint8_t* iv);
+
 void AES_CBC_encrypt_buffer(uint8_t* output, uint8_t* input, uint32_t length, const uint8_t* key, const uint8_t* iv);
 void AES_CBC_decrypt_buffer(uint8_t* output, uint8_t* input, uint32_t length, const uint8_t* key, const uint8_t* iv);
 
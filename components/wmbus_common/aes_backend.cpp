@@ -0,0 +1,96 @@
+#include"aes_backend.h"
+
+#include<string.h>
+
+AESKey::AESKey()
+{
+#if defined(AES_BACKEND_MBEDTLS)
+    mbedtls_aes_init(&enc_ctx_);
+    mbedtls_aes_init(&dec_ctx_);
+#endif
+}
+
+AESKey::AESKey(const std::vector<uint8_t> &key) : AESKey()
+{
+    set(key);
+}
+
+AESKey::AESKey(const AESKey &k) : AESKey()
+{
+    *this = k;
+}
+
+AESKey &AESKey::operator=(const AESKey &k)
+{
+    if (this == &k) return *this;
+
+    // The mbedTLS contexts may point into themselves, so expand again instead of copying them.
+    is_set_ = k.is_set_;
+    memcpy(key_, k.key_, sizeof(key_));
+    if (is_set_) expand();
+    return *this;
+}
+
+AESKey::~AESKey()
+{
+#if defined(AES_BACKEND_MBEDTLS)
+    mbedtls_aes_free(&enc_ctx_);
+    mbedtls_aes_free(&dec_ctx_);
+#endif
+}
+
+void AESKey::set(const std::vector<uint8_t> &key)
+{
+    if (key.size() < sizeof(key_))
+    {
+        clear();
+        return;
+    }
+    memcpy(key_, key.data(), sizeof(key_));
+    is_set_ = true;
+    expand();
+}
+
+void AESKey::clear()
+{
+    is_set_ = false;
+    memset(key_, 0, sizeof(key_));
+}
+
+bool AESKey::sameAs(const std::vector<uint8_t> &key) const
+{
+    if (key.size() < sizeof(key_)) return !is_set_;
+    return is_set_ && memcmp(key_, key.data(), sizeof(key_)) == 0;
+}
+
+void AESKey::expand()
+{
+#if defined(AES_BACKEND_MBEDTLS)
+    mbedtls_aes_setkey_enc(&enc_ctx_, key_, 128);
+    mbedtls_aes_setkey_dec(&dec_ctx_, key_, 128);
+#else
+    AES_init_ctx(&ctx_, key_);
+#endif
+}
+
+void AESKey::encryptBlock(const uint8_t *in, uint8_t *out) const
+{
+#if defined(AES_BACKEND_MBEDTLS)
+    mbedtls_aes_crypt_ecb(&enc_ctx_, MBEDTLS_AES_ENCRYPT, in, out);
+#else
+    if (out != in) memcpy(out, in, 16);
+    AES_ECB_encrypt(&ctx_, out);
+#endif
+}
+
+void AESKey::decryptCBC(const uint8_t *in, uint8_t *out, size_t len, const uint8_t *iv) const
+{
+#if defined(AES_BACKEND_MBEDTLS)
+    // mbedTLS updates the iv it is given.
+    uint8_t iv_copy[16];
+    memcpy(iv_copy, iv, sizeof(iv_copy));
+    mbedtls_aes_crypt_cbc(&dec_ctx_, MBEDTLS_AES_DECRYPT, len, iv_copy, in, out);
+#else
+    AES_CBC_decrypt_buffer(&ctx_, out, in, len, iv);
+#endif
+}
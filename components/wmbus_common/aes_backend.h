@@ -0,0 +1,59 @@
+#ifndef AES_BACKEND_H
+#define AES_BACKEND_H
+
+#include<stddef.h>
+#include<stdint.h>
+#include<vector>
+
+// The AES implementation is picked at compile time. On ESP32 mbedTLS is used, which drives
+// the AES hardware accelerator. Everywhere else the portable software AES in aes.cpp is used,
+// unless AES_BACKEND_MBEDTLS is defined for the build (host tests of the mbedTLS backend).
+#if defined(ESP_PLATFORM) && !defined(AES_BACKEND_MBEDTLS)
+#define AES_BACKEND_MBEDTLS 1
+#endif
+#if defined(AES_BACKEND_MBEDTLS)
+#include"mbedtls/aes.h"
+#else
+#include"aes.h"
+#endif
+
+// An AES-128 key together with its expanded key schedule. The schedule is computed once when
+// the key is set instead of for every block. Encryption and decryption only read the schedule,
+// so the same key can be used from several tasks at the same time.
+struct AESKey
+{
+    AESKey();
+    explicit AESKey(const std::vector<uint8_t> &key);
+    AESKey(const AESKey &k);
+    AESKey &operator=(const AESKey &k);
+    ~AESKey();
+
+    // Uses the first 16 bytes of the key. A shorter key leaves this AESKey unset.
+    void set(const std::vector<uint8_t> &key);
+    void clear();
+    bool isSet() const { return is_set_; }
+    // True if this AESKey was set from the given key, or is unset and the key is unusable.
+    bool sameAs(const std::vector<uint8_t> &key) const;
+
+    // Encrypt a single 16 byte block, in and out may be the same buffer.
+    void encryptBlock(const uint8_t *in, uint8_t *out) const;
+    // Decrypt len bytes, a multiple of 16, in CBC mode. The iv is not modified.
+    void decryptCBC(const uint8_t *in, uint8_t *out, size_t len, const uint8_t *iv) const;
+
+private:
+
+    void expand();
+
+    bool is_set_ {};
+    uint8_t key_[16] {};
+#if defined(AES_BACKEND_MBEDTLS)
+    // mbedTLS keeps separate schedules for encryption and decryption. Its crypt functions
+    // take non const contexts, although they do not modify them.
+    mutable mbedtls_aes_context enc_ctx_;
+    mutable mbedtls_aes_context dec_ctx_;
+#else
+    AES_ctx ctx_ {};
+#endif
+};
+
+#endif
@@ -17,7 +17,6 @@
 
 #include<stdio.h>
 #include<memory.h>
-#include"aes.h"
 #include"aescmac.h"
 #include"util.h"
 
@@ -26,7 +25,7 @@ uchar vec87[16] = {
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x87
 };
 
-void generateSubkeys(uchar *key, uchar *K1, uchar *K2)
+void generateSubkeys(const AESKey &key, uchar *K1, uchar *K2)
 {
     uchar L[16];
     uchar Z[16];
@@ -34,7 +33,7 @@ void generateSubkeys(uchar *key, uchar *K1, uchar *K2)
 
     memset(Z, 0, 16);
 
-    AES_ECB_encrypt(Z, key, L, 16);
+    key.encryptBlock(Z, L);
 
     if (!(L[0] & 0x80))
     {
@@ -57,7 +56,7 @@ void generateSubkeys(uchar *key, uchar *K1, uchar *K2)
     }
 }
 
-void pad(uchar *in, uchar *out, int len)
+void pad(const uchar *in, uchar *out, int len)
 {
     for (int i = 0; i < 16; i++)
     {
@@ -76,7 +75,7 @@ void pad(uchar *in, uchar *out, int len)
     }
 }
 
-void AES_CMAC(uchar *key, uchar *input, int len, uchar *mac)
+void AES_CMAC(const AESKey &key, const uchar *input, int len, uchar *mac)
 {
     bool len_is_multiple_of_block;
     uchar X[16], Y[16];
@@ -112,11 +111,11 @@ void AES_CMAC(uchar *key, uchar *input, int len, uchar *mac)
     for (int i=0; i<num_blocks-1; i++)
     {
         xorit(X, input+(16*i), Y, 16);
-        AES_ECB_encrypt(Y, key, X, 16);
+        key.encryptBlock(Y, X);
     }
 
     xorit(X,M_last,Y, 16);
-    AES_ECB_encrypt(Y, key, X, 16);
+    key.encryptBlock(Y, X);
 
     memcpy(mac, X, 16);
 }
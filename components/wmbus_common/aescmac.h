@@ -18,8 +18,10 @@
 #ifndef _AESCMAC_H_
 #define _AESCMAC_H_
 
+#include"aes_backend.h"
+
 typedef unsigned char uchar;
 
-void AES_CMAC (uchar *key, uchar *input, int length, uchar *mac);
+void AES_CMAC (const AESKey &key, const uchar *input, int length, uchar *mac);
 
 #endif //_AESCMAC_H_
@@ -72,7 +72,7 @@ namespace
         std::vector<uchar> content;
         t->extractPayload(&content);
 
-        std::map<std::string,std::pair<int,DVEntry>> vendor_values;
+        DVEntries vendor_values;
 
         // The first 8 bytes are error flags and a date time.
         // E.g. 0F005B5996000000 therefore we skip the first 8 bytes.
@@ -119,7 +119,7 @@ namespace
                 std::string total;
                 strprintf(&total, "%02x%02x%02x%02x", content[i+0], content[i+1], content[i+2], content[i+3]);
                 int offset = i-1+t->header_size;
-                vendor_values["0413"] = {offset, DVEntry(offset, DifVifKey("0413"), MeasurementType::Instantaneous, 0x13, {}, {}, 0, 0, 0, total) };
+                vendor_values.add(DVEntry(offset, DifVifKey("0413"), MeasurementType::Instantaneous, 0x13, {}, {}, 0, 0, 0, &content[i], 4));
                 double total_water_consumption_m3 {};
                 extractDVdouble(&vendor_values, "0413", &offset, &total_water_consumption_m3);
                 total = "*** 10-"+total+" total consumption (%f m3)";
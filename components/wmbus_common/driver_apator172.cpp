@@ -55,7 +55,7 @@ namespace
         // Overwrite the non-standard 0x11 with 0x07 which means water.
         t->dll_type = 0x07;
 
-        std::map<std::string,std::pair<int,DVEntry>> vendor_values;
+        DVEntries vendor_values;
 
         size_t i=0;
         if (i+4 < content.size())
@@ -64,7 +64,7 @@ namespace
             std::string total;
             strprintf(&total, "%02x%02x%02x%02x", content[i+0], content[i+1], content[i+2], content[i+3]);
             int offset = i-1+t->header_size;
-            vendor_values["0413"] = {offset, DVEntry(offset, DifVifKey("0413"), MeasurementType::Instantaneous, 0x13, {}, {}, 0, 0, 0, total) };
+            vendor_values.add(DVEntry(offset, DifVifKey("0413"), MeasurementType::Instantaneous, 0x13, {}, {}, 0, 0, 0, &content[i], 4));
             double tmp = 0;
             extractDVdouble(&vendor_values, "0413", &offset, &tmp);
             // Single tick seems to be 1/3 of a m3. Divide by 3 and keep a single decimal.
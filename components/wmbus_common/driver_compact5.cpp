@@ -66,7 +66,7 @@ namespace
         // simple wrapped inside a wmbus telegram since the ci-field is 0xa2.
         // Which means that the entire payload is manufacturer specific.
 
-        std::map<std::string,std::pair<int,DVEntry>> vendor_values;
+        DVEntries vendor_values;
         std::vector<uchar> content;
 
         t->extractPayload(&content);
@@ -81,7 +81,7 @@ namespace
         std::string prevs;
         strprintf(&prevs, "%02x%02x%02x", prev_lo, prev_hi, prev_hihi);
         int offset = t->parsed.size()+3;
-        vendor_values["0215"] = { offset, DVEntry(offset, DifVifKey("0215"), MeasurementType::Instantaneous, 0x15, {}, {}, 0, 0, 0, prevs) };
+        vendor_values.add(DVEntry(offset, DifVifKey("0215"), MeasurementType::Instantaneous, 0x15, {}, {}, 0, 0, 0, &content[3], 3));
         Explanation pe(offset, 3, prevs, KindOfData::CONTENT, Understanding::FULL);
         t->explanations.push_back(pe);
         t->addMoreExplanation(offset, " energy used in previous billing period (%f KWH)", prev);
@@ -94,7 +94,7 @@ namespace
         std::string currs;
         strprintf(&currs, "%02x%02x%02x", curr_lo, curr_hi, curr_hihi);
         offset = t->parsed.size()+7;
-        vendor_values["0215"] = { offset, DVEntry(offset, DifVifKey("0215"), MeasurementType::Instantaneous, 0x15, {}, {}, 0, 0, 0, currs) };
+        vendor_values.add(DVEntry(offset, DifVifKey("0215"), MeasurementType::Instantaneous, 0x15, {}, {}, 0, 0, 0, &content[7], 3));
         Explanation ce(offset, 3, currs, KindOfData::CONTENT, Understanding::FULL);
         t->explanations.push_back(ce);
         t->addMoreExplanation(offset, " energy used in current billing period (%f KWH)", curr);
@@ -92,7 +92,7 @@ namespace
     {
         if (t->mfct_0f_index == -1) return; // Check that there is mfct data.
 
-        if (t->dv_entries.count("036E") != 0)
+        if (t->dv_entries.has("036E"))
         {
             decodeRF_RKN0(t);
         }
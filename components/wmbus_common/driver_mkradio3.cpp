@@ -65,7 +65,7 @@ namespace
         // simple wrapped inside a wmbus telegram since the ci-field is 0xa2.
         // Which means that the entire payload is manufacturer specific.
 
-        std::map<std::string,std::pair<int,DVEntry>> vendor_values;
+        DVEntries vendor_values;
         std::vector<uchar> content;
 
         t->extractPayload(&content);
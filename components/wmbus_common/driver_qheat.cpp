@@ -156,34 +156,27 @@ namespace
     }
 
     void Driver::processContent(Telegram *t) {
-        auto it = t->dv_entries.find("0779");
-        if (it != t->dv_entries.end()) {
-            std::vector<uchar> v;
-            auto entry = it->second.second;
-            hex2bin(entry.value.substr(0, 8), &v);
+        DVEntry *dve = t->dv_entries.find("0779");
+        if (dve != NULL && dve->valueSize() >= 8) {
+            DVEntry &entry = *dve;
+            std::string hex = entry.valueHex();
             // FIXME PROBLEM
             Address a;
-            a.id = tostrprintf("%02x%02x%02x%02x", v[3], v[2], v[1], v[0]);
+            a.id = tostrprintf("%02x%02x%02x%02x", entry.valueByte(3), entry.valueByte(2), entry.valueByte(1), entry.valueByte(0));
             t->addresses.push_back(a);
-            std::string info = "*** " + entry.value.substr(0, 8) + " tpl-id (" + t->addresses.back().id + ")";
+            std::string info = "*** " + hex.substr(0, 8) + " tpl-id (" + t->addresses.back().id + ")";
             t->addSpecialExplanation(entry.offset, 4, KindOfData::CONTENT, Understanding::FULL, info.c_str());
 
-            v.clear();
-            hex2bin(entry.value.substr(8, 4), &v);
-            uint16_t tpl_mfct = *(uint16_t *) (&v[0]);
-            info = "*** " + entry.value.substr(8, 4) + " tpl-mfct (" + manufacturerFlag(tpl_mfct) + ")";
+            uint16_t tpl_mfct = entry.valueByte(5) << 8 | entry.valueByte(4);
+            info = "*** " + hex.substr(8, 4) + " tpl-mfct (" + manufacturerFlag(tpl_mfct) + ")";
             t->addSpecialExplanation(entry.offset + 4, 2, KindOfData::PROTOCOL, Understanding::FULL, info.c_str());
 
-            v.clear();
-            hex2bin(entry.value.substr(12, 2), &v);
-            uint8_t tpl_version = v[0];
-            info = "*** " + entry.value.substr(12, 2) + " tpl-version";
+            uint8_t tpl_version = entry.valueByte(6);
+            info = "*** " + hex.substr(12, 2) + " tpl-version";
             t->addSpecialExplanation(entry.offset + 6, 1, KindOfData::PROTOCOL, Understanding::FULL, info.c_str());
 
-            v.clear();
-            hex2bin(entry.value.substr(14, 2), &v);
-            uint8_t tpl_type = v[0];
-            info = "*** " + entry.value.substr(14, 2) + " tpl-type (" + mediaType(v[0], tpl_mfct) + ")";
+            uint8_t tpl_type = entry.valueByte(7);
+            info = "*** " + hex.substr(14, 2) + " tpl-type (" + mediaType(tpl_type, tpl_mfct) + ")";
             t->addSpecialExplanation(entry.offset + 7, 1, KindOfData::PROTOCOL, Understanding::FULL, info.c_str());
 
             t->tpl_id_found = true;
@@ -192,15 +185,15 @@ namespace
             t->tpl_type = tpl_type;
         }
 
-        it = t->dv_entries.find("0DFF5F");
-        if (it != t->dv_entries.end()) {
-            DVEntry entry = it->second.second;
-            if (entry.value.length() == 53 * 2) {
-                qdsExtractWalkByField(t, this, entry, 24, 8, "0C05", "total_energy_consumption", Quantity::Energy);
-                qdsExtractWalkByField(t, this, entry, 32, 4, "426C", "last_year_date", Quantity::Text);
-                qdsExtractWalkByField(t, this, entry, 36, 8, "4C05", "last_year_energy_consumption", Quantity::Energy);
-                qdsExtractWalkByField(t, this, entry, 44, 4, "C2086C", "last_month_date", Quantity::Text);
-                qdsExtractWalkByField(t, this, entry, 48, 8, "CC0805", "last_month_energy_consumption", Quantity::Energy);
+        dve = t->dv_entries.find("0DFF5F");
+        if (dve != NULL) {
+            DVEntry &entry = *dve;
+            if (entry.valueSize() == 53) {
+                qdsExtractWalkByField(t, this, entry, 12, 4, "0C05", "total_energy_consumption", Quantity::Energy);
+                qdsExtractWalkByField(t, this, entry, 16, 2, "426C", "last_year_date", Quantity::Text);
+                qdsExtractWalkByField(t, this, entry, 18, 4, "4C05", "last_year_energy_consumption", Quantity::Energy);
+                qdsExtractWalkByField(t, this, entry, 22, 2, "C2086C", "last_month_date", Quantity::Text);
+                qdsExtractWalkByField(t, this, entry, 24, 4, "CC0805", "last_month_energy_consumption", Quantity::Energy);
             }
         }
     }
@@ -143,19 +143,19 @@ namespace
 }
 
 void Driver::processContent(Telegram *t) {
-    auto it = t->dv_entries.find("0DFF5F");
-    if (it == t->dv_entries.end()) {
+    DVEntry *dve = t->dv_entries.find("0DFF5F");
+    if (dve == NULL) {
         return;
     }
-    DVEntry entry = it->second.second;
-    if (entry.value.length() != 53 * 2) {
+    DVEntry &entry = *dve;
+    if (entry.valueSize() != 53) {
         return;
     }
-    qdsExtractWalkByField(t, this, entry, 24, 8, "0C13", "total", Quantity::Volume);
-    qdsExtractWalkByField(t, this, entry, 32, 4, "426C", "due", Quantity::PointInTime);
-    qdsExtractWalkByField(t, this, entry, 36, 8, "4C13", "due_date", Quantity::Volume);
-    qdsExtractWalkByField(t, this, entry, 44, 4, "C2086C", "due_17", Quantity::PointInTime);
-    qdsExtractWalkByField(t, this, entry, 48, 8, "CC0813", "due_17_date", Quantity::Volume);
+    qdsExtractWalkByField(t, this, entry, 12, 4, "0C13", "total", Quantity::Volume);
+    qdsExtractWalkByField(t, this, entry, 16, 2, "426C", "due", Quantity::PointInTime);
+    qdsExtractWalkByField(t, this, entry, 18, 4, "4C13", "due_date", Quantity::Volume);
+    qdsExtractWalkByField(t, this, entry, 22, 2, "C2086C", "due_17", Quantity::PointInTime);
+    qdsExtractWalkByField(t, this, entry, 24, 4, "CC0813", "due_17_date", Quantity::Volume);
 }
 
 // Test: MyQWater qwater 12353648 NOKEY
@@ -19,6 +19,7 @@
 #include"wmbus.h"
 #include"util.h"
 
+#include<algorithm>
 #include<assert.h>
 #include<cmath>
 #include<math.h>
@@ -167,16 +168,16 @@ bool parseDV(Telegram *t,
              std::vector<uchar> &databytes,
              std::vector<uchar>::iterator data,
              size_t data_len,
-             std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
+             DVEntries *dv_entries,
              std::vector<uchar>::iterator *format,
              size_t format_len,
              uint16_t *format_hash)
 {
-    std::map<std::string,int> dv_count;
     std::vector<uchar> format_bytes;
     std::vector<uchar> id_bytes;
     std::vector<uchar> data_bytes;
-    std::string dv, key;
+    // Occurrences of each difvif in this call, few enough per telegram for a linear search.
+    std::vector<std::pair<DifVifKey,int>> dv_count;
     size_t start_parse_here = t->parsed.size();
     std::vector<uchar>::iterator data_start = data;
     std::vector<uchar>::iterator data_end = data+data_len;
@@ -494,22 +495,18 @@ bool parseDV(Telegram *t,
             }
         }
 
-        dv = "";
-        for (uchar c : id_bytes) {
-            char hex[3];
-            hex[2] = 0;
-            snprintf(hex, 3, "%02X", c);
-            dv.append(hex);
+        DifVifKey key(id_bytes);
+        auto counted = std::find_if(dv_count.begin(), dv_count.end(),
+                                    [&](const std::pair<DifVifKey,int> &c) { return c.first == key; });
+        if (counted == dv_count.end())
+        {
+            dv_count.emplace_back(key, 1);
         }
-        DEBUG_PARSER("(dvparser debug) key \"%s\"\n", dv.c_str());
-
-        int count = ++dv_count[dv];
-        if (count > 1) {
-            strprintf(&key, "%s_%d", dv.c_str(), count);
-        } else {
-            strprintf(&key, "%s", dv.c_str());
+        else
+        {
+            key = DifVifKey(id_bytes, ++counted->second);
         }
-        DEBUG_PARSER("(dvparser debug) DifVif key is %s\n", key.c_str());
+        DEBUG_PARSER("(dvparser debug) DifVif key is %s\n", key.str().c_str());
 
         int remaining = std::distance(data, data_end);
         if (remaining < 1)
@@ -531,30 +528,29 @@ bool parseDV(Telegram *t,
             datalen = remaining-1;
         }
 
-        std::string value = bin2hex(data, data_end, datalen);
+        int value_len = std::max(0, std::min<int>(datalen, std::distance(data, data_end)));
         int offset = start_parse_here+data-data_start;
 
-        (*dv_entries)[key] = { offset, DVEntry(offset,
-                                               key,
-                                               mt,
-                                               Vif(full_vif),
-                                               found_combinable_vifs,
-                                               found_combinable_vifs_raw,
-                                               StorageNr(storage_nr),
-                                               TariffNr(tariff),
-                                               SubUnitNr(subunit),
-                                               value) };
+        DVEntry *dve = &dv_entries->add(DVEntry(offset,
+                                                key,
+                                                mt,
+                                                Vif(full_vif),
+                                                found_combinable_vifs,
+                                                found_combinable_vifs_raw,
+                                                StorageNr(storage_nr),
+                                                TariffNr(tariff),
+                                                SubUnitNr(subunit),
+                                                value_len > 0 ? &*data : nullptr,
+                                                value_len));
 
-        DVEntry *dve = &(*dv_entries)[key].second;
+        assert(key == dve->dif_vif_key);
 
         trace("[DVPARSER] entry %s\n", dve->str().c_str());
 
-        assert(key == dve->dif_vif_key.str());
-
-        if (value.length() > 0) {
+        if (value_len > 0) {
             // This call increments data with datalen.
-            t->addExplanationAndIncrementPos(data, datalen, KindOfData::CONTENT, Understanding::NONE, "%s", value.c_str());
-            DEBUG_PARSER("(dvparser debug) data \"%s\"\n\n", value.c_str());
+            t->addExplanationAndIncrementPos(data, datalen, KindOfData::CONTENT, Understanding::NONE, "%s", dve->valueHex().c_str());
+            DEBUG_PARSER("(dvparser debug) data \"%s\"\n\n", dve->valueHex().c_str());
         }
         if (remaining == datalen || data == databytes.end()) {
             // We are done here!
@@ -562,11 +558,11 @@ bool parseDV(Telegram *t,
         }
     }
 
-    std::string format_string = bin2hex(format_bytes);
     uint16_t hash = crc16_EN13757(safeButUnsafeVectorPtr(format_bytes), format_bytes.size());
 
     if (data_has_difvifs) {
         if (hash_to_format_.count(hash) == 0) {
+            std::string format_string = bin2hex(format_bytes);
             hash_to_format_[hash] = format_string;
             debug("(dvparser) found new format \"%s\" with hash %x, remembering!\n", format_string.c_str(), hash);
         }
@@ -575,32 +571,41 @@ bool parseDV(Telegram *t,
     return true;
 }
 
-bool hasKey(std::map<std::string,std::pair<int,DVEntry>> *dv_entries, std::string key)
+bool hasKey(DVEntries *dv_entries, const DifVifKey &key)
 {
-    return dv_entries->count(key) > 0;
+    return dv_entries->has(key);
 }
 
 bool findKey(MeasurementType mit, VIFRange vif_range, StorageNr storagenr, TariffNr tariffnr,
-             std::string *key, std::map<std::string,std::pair<int,DVEntry>> *dv_entries)
+             std::string *key, DVEntries *dv_entries)
 {
     return findKeyWithNr(mit, vif_range, storagenr, tariffnr, 1, key, dv_entries);
 }
 
 bool findKeyWithNr(MeasurementType mit, VIFRange vif_range, StorageNr storagenr, TariffNr tariffnr, int nr,
-                   std::string *key, std::map<std::string,std::pair<int,DVEntry>> *dv_entries)
+                   std::string *key, DVEntries *dv_entries)
+{
+    DVEntry *dve = findEntryWithNr(mit, vif_range, storagenr, tariffnr, nr, dv_entries);
+    if (dve == NULL) return false;
+    *key = dve->dif_vif_key.str();
+    return true;
+}
+
+DVEntry *findEntryWithNr(MeasurementType mit, VIFRange vif_range, StorageNr storagenr, TariffNr tariffnr, int nr,
+                         DVEntries *dv_entries)
 {
     /*debug("(dvparser) looking for type=%s vifrange=%s storagenr=%d tariffnr=%d\n",
       measurementTypeName(mit).c_str(), toString(vif_range), storagenr.intValue(), tariffnr.intValue());*/
 
-    for (auto& v : *dv_entries)
+    for (DVEntry &v : *dv_entries)
     {
-        MeasurementType ty = v.second.second.measurement_type;
-        Vif vi = v.second.second.vif;
-        StorageNr sn = v.second.second.storage_nr;
-        TariffNr tn = v.second.second.tariff_nr;
+        MeasurementType ty = v.measurement_type;
+        Vif vi = v.vif;
+        StorageNr sn = v.storage_nr;
+        TariffNr tn = v.tariff_nr;
 
         /* debug("(dvparser) match? %s type=%s vife=%x (%s) and storagenr=%d\n",
-              v.first.c_str(),
+              v.dif_vif_key.str().c_str(),
               measurementTypeName(ty).c_str(), vi.intValue(), storagenr, sn);*/
 
         if (isInsideVIFRange(vi, vif_range) &&
@@ -608,27 +613,18 @@ bool findKeyWithNr(MeasurementType mit, VIFRange vif_range, StorageNr storagenr,
             (storagenr == AnyStorageNr || storagenr == sn) &&
             (tariffnr == AnyTariffNr || tariffnr == tn))
         {
-            *key = v.first;
             nr--;
-            if (nr <= 0) return true;
+            if (nr <= 0) return &v;
             debug("(dvparser) found key %s for type=%s vif=%x storagenr=%d\n",
-                  v.first.c_str(), measurementTypeName(ty).c_str(),
+                  v.dif_vif_key.str().c_str(), measurementTypeName(ty).c_str(),
                   vi.intValue(), storagenr.intValue());
         }
     }
-    return false;
-}
-
-void extractDV(DifVifKey &dvk, uchar *dif, int *vif, bool *has_difes, bool *has_vifes)
-{
-    std::string tmp = dvk.str();
-    extractDV(tmp, dif, vif, has_difes, has_vifes);
+    return NULL;
 }
 
-void extractDV(std::string &s, uchar *dif, int *vif, bool *has_difes, bool *has_vifes)
+static void extractDVFromBytes(const std::string &bytes, uchar *dif, int *vif, bool *has_difes, bool *has_vifes)
 {
-    std::vector<uchar> bytes;
-    hex2bin(s, &bytes);
     size_t i = 0;
     *has_difes = false;
     *has_vifes = false;
@@ -653,7 +649,7 @@ void extractDV(std::string &s, uchar *dif, int *vif, bool *has_difes, bool *has_
         return;
     }
 
-    *vif = bytes[i];
+    *vif = (uchar)bytes[i];
     if (*vif == 0xfb || // first extension
         *vif == 0xfd || // second extensio
         *vif == 0xef || // third extension
@@ -662,7 +658,7 @@ void extractDV(std::string &s, uchar *dif, int *vif, bool *has_difes, bool *has_
         if (i+1 < bytes.size())
         {
             // Create an extended vif, like 0xfd31 for example.
-            *vif = bytes[i] << 8 | bytes[i+1];
+            *vif = (uchar)bytes[i] << 8 | (uchar)bytes[i+1];
             i++;
         }
     }
@@ -674,134 +670,326 @@ void extractDV(std::string &s, uchar *dif, int *vif, bool *has_difes, bool *has_
     }
 }
 
-bool extractDVuint8(std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
-                    std::string key,
+void extractDV(DifVifKey &dvk, uchar *dif, int *vif, bool *has_difes, bool *has_vifes)
+{
+    *dif = dvk.dif();
+    *vif = dvk.vif();
+    *has_difes = dvk.hasDifes();
+    *has_vifes = dvk.hasVifes();
+}
+
+void extractDV(std::string &s, uchar *dif, int *vif, bool *has_difes, bool *has_vifes)
+{
+    std::vector<uchar> bytes;
+    hex2bin(s, &bytes);
+    extractDVFromBytes(std::string(bytes.begin(), bytes.end()), dif, vif, has_difes, has_vifes);
+}
+
+DifVifKey::DifVifKey(const char *key)
+{
+    // Decode the hex digits straight into bytes_, the _2 suffix of repeated difvifs becomes nr_.
+    while (key[0] != 0 && key[0] != '_' && key[1] != 0)
+    {
+        int hi = char2int(key[0]);
+        int lo = char2int(key[1]);
+        if (hi < 0 || lo < 0) break;
+        bytes_.push_back((char)(hi*16 + lo));
+        key += 2;
+    }
+    if (key[0] == '_')
+    {
+        nr_ = atoi(key+1);
+    }
+    init();
+}
+
+DifVifKey::DifVifKey(const std::vector<uchar> &difvif, int nr) :
+    bytes_(difvif.begin(), difvif.end()),
+    nr_(nr)
+{
+    init();
+}
+
+void DifVifKey::init()
+{
+    if (bytes_.size() <= 7)
+    {
+        // Length in the top byte followed by the bytes themselves, e.g. 0x0000000000020C13.
+        packed_ = (uint64_t)bytes_.size() << 56;
+        for (size_t i = 0; i < bytes_.size(); ++i)
+        {
+            packed_ |= (uint64_t)(uchar)bytes_[i] << (8*(bytes_.size()-1-i));
+        }
+    }
+    else
+    {
+        // FNV-1a of the bytes, marked as such by a length byte that cannot occur above.
+        uint64_t h = 14695981039346656037ULL;
+        for (char c : bytes_)
+        {
+            h = (h ^ (uchar)c) * 1099511628211ULL;
+        }
+        packed_ = h | ((uint64_t)0xff << 56);
+    }
+    extractDVFromBytes(bytes_, &dif_, &vif_, &has_difes_, &has_vifes_);
+}
+
+std::string DifVifKey::str() const
+{
+    std::string s = bin2hex((const uchar*)bytes_.data(), bytes_.size());
+    if (nr_ > 1)
+    {
+        s += "_" + std::to_string(nr_);
+    }
+    return s;
+}
+
+size_t DifVifKey::hash() const
+{
+    uint64_t h = (packed_ ^ ((uint64_t)nr_ << 48)) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> 32);
+}
+
+DVEntry &DVEntries::add(DVEntry dve)
+{
+    DVEntry *existing = find(dve.dif_vif_key);
+    if (existing != NULL)
+    {
+        *existing = std::move(dve);
+        return *existing;
+    }
+
+    entries_.push_back(std::move(dve));
+
+    // Keep the index at most half full so that probing stays short.
+    if (entries_.size()*2 > index_.size())
+    {
+        index_.assign(std::max<size_t>(16, index_.size()*2), 0);
+        for (size_t i = 0; i < entries_.size(); ++i) insertIndex(i);
+    }
+    else
+    {
+        insertIndex(entries_.size()-1);
+    }
+    return entries_.back();
+}
+
+void DVEntries::insertIndex(size_t entry)
+{
+    size_t mask = index_.size()-1;
+    size_t i = entries_[entry].dif_vif_key.hash() & mask;
+    while (index_[i] != 0) i = (i+1) & mask;
+    index_[i] = entry+1;
+}
+
+DVEntry *DVEntries::find(const DifVifKey &key)
+{
+    if (index_.empty()) return NULL;
+
+    size_t mask = index_.size()-1;
+    for (size_t i = key.hash() & mask; index_[i] != 0; i = (i+1) & mask)
+    {
+        DVEntry &dve = entries_[index_[i]-1];
+        if (dve.dif_vif_key == key) return &dve;
+    }
+    return NULL;
+}
+
+uint64_t DVEntries::layoutHash() const
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (const DVEntry &dve : entries_)
+    {
+        h = (h ^ dve.dif_vif_key.packed()) * 1099511628211ULL;
+        h = (h ^ (uint64_t)dve.dif_vif_key.nr()) * 1099511628211ULL;
+    }
+    return h;
+}
+
+void DVEntries::clear()
+{
+    entries_.clear();
+    std::fill(index_.begin(), index_.end(), 0);
+}
+
+bool extractDVuint8(DVEntries *dv_entries,
+                    const DifVifKey &key,
                     int *offset,
                     uchar *value)
 {
-    if ((*dv_entries).count(key) == 0) {
-        verbose("(dvparser) warning: cannot extract uint8 from non-existant key \"%s\"\n", key.c_str());
+    DVEntry *dve = dv_entries->find(key);
+    if (dve == NULL) {
+        verbose("(dvparser) warning: cannot extract uint8 from non-existant key \"%s\"\n", key.str().c_str());
         *offset = -1;
         *value = 0;
         return false;
     }
 
-    std::pair<int,DVEntry>&  p = (*dv_entries)[key];
-    *offset = p.first;
-    std::vector<uchar> v;
-    hex2bin(p.second.value, &v);
+    *offset = dve->offset;
+    if (dve->valueSize() < 1) {
+        *value = 0;
+        return false;
+    }
 
-    *value = v[0];
+    *value = dve->valueByte(0);
     return true;
 }
 
-bool extractDVuint16(std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
-                     std::string key,
+bool extractDVuint16(DVEntries *dv_entries,
+                     const DifVifKey &key,
                      int *offset,
                      uint16_t *value)
 {
-    if ((*dv_entries).count(key) == 0) {
-        verbose("(dvparser) warning: cannot extract uint16 from non-existant key \"%s\"\n", key.c_str());
+    DVEntry *dve = dv_entries->find(key);
+    if (dve == NULL) {
+        verbose("(dvparser) warning: cannot extract uint16 from non-existant key \"%s\"\n", key.str().c_str());
         *offset = -1;
         *value = 0;
         return false;
     }
 
-    std::pair<int,DVEntry>&  p = (*dv_entries)[key];
-    *offset = p.first;
-    std::vector<uchar> v;
-    hex2bin(p.second.value, &v);
+    *offset = dve->offset;
+    if (dve->valueSize() < 2) {
+        *value = 0;
+        return false;
+    }
 
-    *value = v[1]<<8 | v[0];
+    *value = dve->valueByte(1)<<8 | dve->valueByte(0);
     return true;
 }
 
-bool extractDVuint24(std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
-                     std::string key,
+bool extractDVuint24(DVEntries *dv_entries,
+                     const DifVifKey &key,
                      int *offset,
                      uint32_t *value)
 {
-    if ((*dv_entries).count(key) == 0) {
-        verbose("(dvparser) warning: cannot extract uint24 from non-existant key \"%s\"\n", key.c_str());
+    DVEntry *dve = dv_entries->find(key);
+    if (dve == NULL) {
+        verbose("(dvparser) warning: cannot extract uint24 from non-existant key \"%s\"\n", key.str().c_str());
         *offset = -1;
         *value = 0;
         return false;
     }
 
-    std::pair<int,DVEntry>&  p = (*dv_entries)[key];
-    *offset = p.first;
-    std::vector<uchar> v;
-    hex2bin(p.second.value, &v);
+    *offset = dve->offset;
+    if (dve->valueSize() < 3) {
+        *value = 0;
+        return false;
+    }
 
-    *value = v[2] << 16 | v[1]<<8 | v[0];
+    *value = dve->valueByte(2) << 16 | dve->valueByte(1)<<8 | dve->valueByte(0);
     return true;
 }
 
-bool extractDVuint32(std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
-                     std::string key,
+bool extractDVuint32(DVEntries *dv_entries,
+                     const DifVifKey &key,
                      int *offset,
                      uint32_t *value)
 {
-    if ((*dv_entries).count(key) == 0) {
-        verbose("(dvparser) warning: cannot extract uint32 from non-existant key \"%s\"\n", key.c_str());
+    DVEntry *dve = dv_entries->find(key);
+    if (dve == NULL) {
+        verbose("(dvparser) warning: cannot extract uint32 from non-existant key \"%s\"\n", key.str().c_str());
         *offset = -1;
         *value = 0;
         return false;
     }
 
-    std::pair<int,DVEntry>&  p = (*dv_entries)[key];
-    *offset = p.first;
-    std::vector<uchar> v;
-    hex2bin(p.second.value, &v);
+    *offset = dve->offset;
+    if (dve->valueSize() < 4) {
+        *value = 0;
+        return false;
+    }
 
-    *value = (uint32_t(v[3]) << 24) |  (uint32_t(v[2]) << 16) | (uint32_t(v[1])<<8) | uint32_t(v[0]);
+    *value = (uint32_t(dve->valueByte(3)) << 24) |  (uint32_t(dve->valueByte(2)) << 16) | (uint32_t(dve->valueByte(1))<<8) | uint32_t(dve->valueByte(0));
     return true;
 }
 
-bool extractDVdouble(std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
-                     std::string key,
+bool extractDVdouble(DVEntries *dv_entries,
+                     const DifVifKey &key,
                      int *offset,
                      double *value,
                      bool auto_scale,
                      bool force_unsigned)
 {
-    if ((*dv_entries).count(key) == 0) {
-        verbose("(dvparser) warning: cannot extract double from non-existant key \"%s\"\n", key.c_str());
+    DVEntry *dve = dv_entries->find(key);
+    if (dve == NULL) {
+        verbose("(dvparser) warning: cannot extract double from non-existant key \"%s\"\n", key.str().c_str());
         *offset = 0;
         *value = 0;
         return false;
     }
-    std::pair<int,DVEntry>&  p = (*dv_entries)[key];
-    *offset = p.first;
+    *offset = dve->offset;
 
-    if (p.second.value.length() == 0) {
-        verbose("(dvparser) warning: key found but no data  \"%s\"\n", key.c_str());
+    if (dve->valueSize() == 0) {
+        verbose("(dvparser) warning: key found but no data  \"%s\"\n", key.str().c_str());
         *offset = 0;
         *value = 0;
         return false;
     }
 
-    return p.second.extractDouble(value, auto_scale, force_unsigned);
+    return dve->extractDouble(value, auto_scale, force_unsigned);
 }
 
-bool checkSizeHex(size_t expected_len, DifVifKey &dvk, std::string &v)
+bool checkSize(size_t expected_len, DifVifKey &dvk, DVEntry &e)
 {
-    if (v.length() == expected_len) return true;
+    if (e.valueSize() == expected_len) return true;
 
-    warning("(dvparser) bad decode since difvif %s expected %d hex chars but got \"%s\"\n",
-            dvk.str().c_str(), expected_len, v.c_str());
+    warning("(dvparser) bad decode since difvif %s expected %zu bytes but got \"%s\"\n",
+            dvk.str().c_str(), expected_len, e.valueHex().c_str());
     return false;
 }
 
-bool is_all_F(std::string &v)
+bool is_all_F(DVEntry &e)
 {
-    for (size_t i = 0; i < v.length(); ++i)
+    for (size_t i = 0; i < e.valueSize(); ++i)
     {
-        if (v[i] != 'F') return false;
+        if (e.valueByte(i) != 0xff) return false;
     }
     return true;
 }
 
+// Size in bytes of the fixed length binary integer (0x1-0x4,0x6,0x7) and bcd (0x9-0xC,0xE) data fields.
+static size_t difDataSize(int t)
+{
+    switch (t)
+    {
+    case 0x1: case 0x9: return 1;
+    case 0x2: case 0xA: return 2;
+    case 0x3: case 0xB: return 3;
+    case 0x4: case 0xC: return 4;
+    case 0x6: case 0xE: return 6;
+    case 0x7: return 8;
+    }
+    return 0;
+}
+
+static uint64_t decodeBinary(DVEntry &e)
+{
+    // Little endian.
+    uint64_t raw = 0;
+    for (size_t i = e.valueSize(); i > 0; --i)
+    {
+        raw = raw << 8 | e.valueByte(i-1);
+    }
+    return raw;
+}
+
+static uint64_t decodeBCD(DVEntry &e, bool *negate)
+{
+    // Little endian bcd, 74140000 -> 00001474
+    // An F in the most significant nibble marks a negative value.
+    uint64_t raw = 0;
+    *negate = false;
+    for (size_t i = e.valueSize(); i > 0; --i)
+    {
+        int hi = e.valueByte(i-1) >> 4;
+        int lo = e.valueByte(i-1) & 0xf;
+        if (i == e.valueSize() && hi == 0xf) { *negate = true; hi = 0; }
+        raw = raw*100 + hi*10 + lo;
+    }
+    return raw;
+}
+
 bool DVEntry::extractDouble(double *out, bool auto_scale, bool force_unsigned)
 {
     int t = dif_vif_key.dif() & 0xf;
@@ -822,56 +1010,15 @@ bool DVEntry::extractDouble(double *out, bool auto_scale, bool force_unsigned)
         t == 0x6 || // 48 Bit Integer/Binary
         t == 0x7)   // 64 Bit Integer/Binary
     {
-        std::vector<uchar> v;
-        hex2bin(value, &v);
-        uint64_t raw = 0;
+        size_t size = difDataSize(t);
+        if (!checkSize(size, dif_vif_key, *this)) return false;
+        uint64_t raw = decodeBinary(*this);
         bool negate = false;
         uint64_t negate_mask = 0;
-        if (t == 0x1) {
-            if (!checkSizeHex(2, dif_vif_key, value)) return false;
-            assert(v.size() == 1);
-            raw = v[0];
-            if (!force_unsigned && (raw & (uint64_t)0x80UL) != 0) { negate = true; negate_mask = ~((uint64_t)0)<<8; }
-        } else if (t == 0x2) {
-            if (!checkSizeHex(4, dif_vif_key, value)) return false;
-            assert(v.size() == 2);
-            raw = v[1]*256 + v[0];
-            if (!force_unsigned && (raw & (uint64_t)0x8000UL) != 0) { negate = true; negate_mask = ~((uint64_t)0)<<16; }
-        } else if (t == 0x3) {
-            if (!checkSizeHex(6, dif_vif_key, value)) return false;
-            assert(v.size() == 3);
-            raw = v[2]*256*256 + v[1]*256 + v[0];
-            if (!force_unsigned && (raw & (uint64_t)0x800000UL) != 0) { negate = true; negate_mask = ~((uint64_t)0)<<24; }
-        } else if (t == 0x4) {
-            if (!checkSizeHex(8, dif_vif_key, value)) return false;
-            assert(v.size() == 4);
-            raw = ((unsigned int)v[3])*256*256*256
-                + ((unsigned int)v[2])*256*256
-                + ((unsigned int)v[1])*256
-                + ((unsigned int)v[0]);
-            if (!force_unsigned && (raw & (uint64_t)0x80000000UL) != 0) { negate = true; negate_mask = ~((uint64_t)0)<<32; }
-        } else if (t == 0x6) {
-            if (!checkSizeHex(12, dif_vif_key, value)) return false;
-            assert(v.size() == 6);
-            raw = ((uint64_t)v[5])*256*256*256*256*256
-                + ((uint64_t)v[4])*256*256*256*256
-                + ((uint64_t)v[3])*256*256*256
-                + ((uint64_t)v[2])*256*256
-                + ((uint64_t)v[1])*256
-                + ((uint64_t)v[0]);
-            if (!force_unsigned && (raw & (uint64_t)0x800000000000UL) != 0) { negate = true; negate_mask = ~((uint64_t)0)<<48; }
-        } else if (t == 0x7) {
-            if (!checkSizeHex(16, dif_vif_key, value)) return false;
-            assert(v.size() == 8);
-            raw = ((uint64_t)v[7])*256*256*256*256*256*256*256
-                + ((uint64_t)v[6])*256*256*256*256*256*256
-                + ((uint64_t)v[5])*256*256*256*256*256
-                + ((uint64_t)v[4])*256*256*256*256
-                + ((uint64_t)v[3])*256*256*256
-                + ((uint64_t)v[2])*256*256
-                + ((uint64_t)v[1])*256
-                + ((uint64_t)v[0]);
-            if (!force_unsigned && (raw & (uint64_t)0x8000000000000000UL) != 0) { negate = true; negate_mask = 0; }
+        if (!force_unsigned && (raw & ((uint64_t)1 << (size*8-1))) != 0)
+        {
+            negate = true;
+            negate_mask = size < 8 ? ~((uint64_t)0) << (size*8) : 0;
         }
         double scale = 1.0;
         double draw = (double)raw;
@@ -891,48 +1038,14 @@ bool DVEntry::extractDouble(double *out, bool auto_scale, bool force_unsigned)
     {
         // Negative BCD values are always visible in bcd. I.e. they are always signed.
         // Ignore assumption on signedness.
-        // 74140000 -> 00001474
-        std::string& v = value;
-        uint64_t raw = 0;
-        bool negate = false;
-
-        if (is_all_F(v))
+        if (is_all_F(*this))
         {
             *out = std::nan("");
             return false;
         }
-        if (t == 0x9) {
-            if (!checkSizeHex(2, dif_vif_key, v)) return false;
-            if (v[0] == 'F') { negate = true; v[0] = '0'; }
-            raw = (v[0]-'0')*10 + (v[1]-'0');
-        } else if (t ==  0xA) {
-            if (!checkSizeHex(4, dif_vif_key, v)) return false;
-            if (v[2] == 'F') { negate = true; v[2] = '0'; }
-            raw = (v[2]-'0')*10*10*10 + (v[3]-'0')*10*10
-                + (v[0]-'0')*10 + (v[1]-'0');
-        } else if (t ==  0xB) {
-            if (!checkSizeHex(6, dif_vif_key, v)) return false;
-            if (v[4] == 'F') { negate = true; v[4] = '0'; }
-            raw = (v[4]-'0')*10*10*10*10*10 + (v[5]-'0')*10*10*10*10
-                + (v[2]-'0')*10*10*10 + (v[3]-'0')*10*10
-                + (v[0]-'0')*10 + (v[1]-'0');
-        } else if (t ==  0xC) {
-            if (!checkSizeHex(8, dif_vif_key, v)) return false;
-            if (v[6] == 'F') { negate = true; v[6] = '0'; }
-            raw = (v[6]-'0')*10*10*10*10*10*10*10 + (v[7]-'0')*10*10*10*10*10*10
-                + (v[4]-'0')*10*10*10*10*10 + (v[5]-'0')*10*10*10*10
-                + (v[2]-'0')*10*10*10 + (v[3]-'0')*10*10
-                + (v[0]-'0')*10 + (v[1]-'0');
-        } else if (t ==  0xE) {
-            if (!checkSizeHex(12, dif_vif_key, v)) return false;
-            if (v[10] == 'F') { negate = true; v[10] = '0'; }
-            raw =(v[10]-'0')*10*10*10*10*10*10*10*10*10*10*10 + (v[11]-'0')*10*10*10*10*10*10*10*10*10*10
-                + (v[8]-'0')*10*10*10*10*10*10*10*10*10 + (v[9]-'0')*10*10*10*10*10*10*10*10
-                + (v[6]-'0')*10*10*10*10*10*10*10 + (v[7]-'0')*10*10*10*10*10*10
-                + (v[4]-'0')*10*10*10*10*10 + (v[5]-'0')*10*10*10*10
-                + (v[2]-'0')*10*10*10 + (v[3]-'0')*10*10
-                + (v[0]-'0')*10 + (v[1]-'0');
-        }
+        if (!checkSize(difDataSize(t), dif_vif_key, *this)) return false;
+        bool negate = false;
+        uint64_t raw = decodeBCD(*this, &negate);
         double scale = 1.0;
         double draw = (double)raw;
         if (negate)
@@ -945,12 +1058,9 @@ bool DVEntry::extractDouble(double *out, bool auto_scale, bool force_unsigned)
     else
     if (t == 0x5) // 32 Bit Real
     {
-        std::vector<uchar> v;
-        hex2bin(value, &v);
-        if (!checkSizeHex(8, dif_vif_key, value)) return false;
-        assert(v.size() == 4);
+        if (!checkSize(4, dif_vif_key, *this)) return false;
         RealConversion rc;
-        rc.i = v[3]<<24 | v[2]<<16 | v[1]<<8 | v[0];
+        rc.i = (uint32_t)decodeBinary(*this);
 
         // Assumes float uses the standard IEEE 754 bit set.
         // 1 bit sign,  8 bit exp, 23 bit mantissa
@@ -970,29 +1080,29 @@ bool DVEntry::extractDouble(double *out, bool auto_scale, bool force_unsigned)
     return true;
 }
 
-bool extractDVlong(std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
-                   std::string key,
+bool extractDVlong(DVEntries *dv_entries,
+                   const DifVifKey &key,
                    int *offset,
                    uint64_t *out)
 {
-    if ((*dv_entries).count(key) == 0) {
-        verbose("(dvparser) warning: cannot extract long from non-existant key \"%s\"\n", key.c_str());
+    DVEntry *dve = dv_entries->find(key);
+    if (dve == NULL) {
+        verbose("(dvparser) warning: cannot extract long from non-existant key \"%s\"\n", key.str().c_str());
         *offset = 0;
         *out = 0;
         return false;
     }
 
-    std::pair<int,DVEntry>&  p = (*dv_entries)[key];
-    *offset = p.first;
+    *offset = dve->offset;
 
-    if (p.second.value.length() == 0) {
-        verbose("(dvparser) warning: key found but no data  \"%s\"\n", key.c_str());
+    if (dve->valueSize() == 0) {
+        verbose("(dvparser) warning: key found but no data  \"%s\"\n", key.str().c_str());
         *offset = 0;
         *out = 0;
         return false;
     }
 
-    return p.second.extractLong(out);
+    return dve->extractLong(out);
 }
 
 bool DVEntry::extractLong(uint64_t *out)
@@ -1005,50 +1115,8 @@ bool DVEntry::extractLong(uint64_t *out)
         t == 0x6 || // 48 Bit Integer/Binary
         t == 0x7)   // 64 Bit Integer/Binary
     {
-        std::vector<uchar> v;
-        hex2bin(value, &v);
-        uint64_t raw = 0;
-        if (t == 0x1) {
-            if (!checkSizeHex(2, dif_vif_key, value)) return false;
-            assert(v.size() == 1);
-            raw = v[0];
-        } else if (t == 0x2) {
-            if (!checkSizeHex(4, dif_vif_key, value)) return false;
-            assert(v.size() == 2);
-            raw = v[1]*256 + v[0];
-        } else if (t == 0x3) {
-            if (!checkSizeHex(6, dif_vif_key, value)) return false;
-            assert(v.size() == 3);
-            raw = v[2]*256*256 + v[1]*256 + v[0];
-        } else if (t == 0x4) {
-            if (!checkSizeHex(8, dif_vif_key, value)) return false;
-            assert(v.size() == 4);
-            raw = ((unsigned int)v[3])*256*256*256
-                + ((unsigned int)v[2])*256*256
-                + ((unsigned int)v[1])*256
-                + ((unsigned int)v[0]);
-        } else if (t == 0x6) {
-            if (!checkSizeHex(12, dif_vif_key, value)) return false;
-            assert(v.size() == 6);
-            raw = ((uint64_t)v[5])*256*256*256*256*256
-                + ((uint64_t)v[4])*256*256*256*256
-                + ((uint64_t)v[3])*256*256*256
-                + ((uint64_t)v[2])*256*256
-                + ((uint64_t)v[1])*256
-                + ((uint64_t)v[0]);
-        } else if (t == 0x7) {
-            if (!checkSizeHex(16, dif_vif_key, value)) return false;
-            assert(v.size() == 8);
-            raw = ((uint64_t)v[7])*256*256*256*256*256*256*256
-                + ((uint64_t)v[6])*256*256*256*256*256*256
-                + ((uint64_t)v[5])*256*256*256*256*256
-                + ((uint64_t)v[4])*256*256*256*256
-                + ((uint64_t)v[3])*256*256*256
-                + ((uint64_t)v[2])*256*256
-                + ((uint64_t)v[1])*256
-                + ((uint64_t)v[0]);
-        }
-        *out = raw;
+        if (!checkSize(difDataSize(t), dif_vif_key, *this)) return false;
+        *out = decodeBinary(*this);
     }
     else
     if (t == 0x9 || // 2 digit BCD
@@ -1057,51 +1125,13 @@ bool DVEntry::extractLong(uint64_t *out)
         t == 0xC || // 8 digit BCD
         t == 0xE)   // 12 digit BCD
     {
-        // 74140000 -> 00001474
-        std::string& v = value;
-        if (is_all_F(v))
+        if (is_all_F(*this))
         {
             return false;
         }
-        uint64_t raw = 0;
+        if (!checkSize(difDataSize(t), dif_vif_key, *this)) return false;
         bool negate = false;
-        if (t == 0x9) {
-            if (!checkSizeHex(2, dif_vif_key, value)) return false;
-            if (v[0] == 'F') { negate = true; v[0] = '0'; }
-            assert(v.size() == 2);
-            raw = (v[0]-'0')*10 + (v[1]-'0');
-        } else if (t ==  0xA) {
-            if (!checkSizeHex(4, dif_vif_key, value)) return false;
-            if (v[2] == 'F') { negate = true; v[2] = '0'; }
-            assert(v.size() == 4);
-            raw = (v[2]-'0')*10*10*10 + (v[3]-'0')*10*10
-                + (v[0]-'0')*10 + (v[1]-'0');
-        } else if (t ==  0xB) {
-            if (!checkSizeHex(6, dif_vif_key, value)) return false;
-            if (v[4] == 'F') { negate = true; v[4] = '0'; }
-            assert(v.size() == 6);
-            raw = (v[4]-'0')*10*10*10*10*10 + (v[5]-'0')*10*10*10*10
-                + (v[2]-'0')*10*10*10 + (v[3]-'0')*10*10
-                + (v[0]-'0')*10 + (v[1]-'0');
-        } else if (t ==  0xC) {
-            if (!checkSizeHex(8, dif_vif_key, value)) return false;
-            if (v[6] == 'F') { negate = true; v[6] = '0'; }
-            assert(v.size() == 8);
-            raw = (v[6]-'0')*10*10*10*10*10*10*10 + (v[7]-'0')*10*10*10*10*10*10
-                + (v[4]-'0')*10*10*10*10*10 + (v[5]-'0')*10*10*10*10
-                + (v[2]-'0')*10*10*10 + (v[3]-'0')*10*10
-                + (v[0]-'0')*10 + (v[1]-'0');
-        } else if (t ==  0xE) {
-            if (!checkSizeHex(12, dif_vif_key, value)) return false;
-            if (v[10] == 'F') { negate = true; v[10] = '0'; }
-            assert(v.size() == 12);
-            raw =(v[10]-'0')*10*10*10*10*10*10*10*10*10*10*10 + (v[11]-'0')*10*10*10*10*10*10*10*10*10*10
-                + (v[8]-'0')*10*10*10*10*10*10*10*10*10 + (v[9]-'0')*10*10*10*10*10*10*10*10
-                + (v[6]-'0')*10*10*10*10*10*10*10 + (v[7]-'0')*10*10*10*10*10*10
-                + (v[4]-'0')*10*10*10*10*10 + (v[5]-'0')*10*10*10*10
-                + (v[2]-'0')*10*10*10 + (v[3]-'0')*10*10
-                + (v[0]-'0')*10 + (v[1]-'0');
-        }
+        uint64_t raw = decodeBCD(*this, &negate);
 
         if (negate)
         {
@@ -1118,45 +1148,45 @@ bool DVEntry::extractLong(uint64_t *out)
     return true;
 }
 
-bool extractDVHexString(std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
-                        std::string key,
+bool extractDVHexString(DVEntries *dv_entries,
+                        const DifVifKey &key,
                         int *offset,
                         std::string *value)
 {
-    if ((*dv_entries).count(key) == 0) {
-        verbose("(dvparser) warning: cannot extract std::string from non-existant key \"%s\"\n", key.c_str());
+    DVEntry *dve = dv_entries->find(key);
+    if (dve == NULL) {
+        verbose("(dvparser) warning: cannot extract std::string from non-existant key \"%s\"\n", key.str().c_str());
         *offset = -1;
         return false;
     }
-    std::pair<int,DVEntry>&  p = (*dv_entries)[key];
-    *offset = p.first;
-    *value = p.second.value;
+    *offset = dve->offset;
+    *value = dve->valueHex();
 
     return true;
 }
 
 
-bool extractDVReadableString(std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
-                             std::string key,
+bool extractDVReadableString(DVEntries *dv_entries,
+                             const DifVifKey &key,
                              int *offset,
                              std::string *out)
 {
-    if ((*dv_entries).count(key) == 0) {
-        verbose("(dvparser) warning: cannot extract std::string from non-existant key \"%s\"\n", key.c_str());
+    DVEntry *dve = dv_entries->find(key);
+    if (dve == NULL) {
+        verbose("(dvparser) warning: cannot extract std::string from non-existant key \"%s\"\n", key.str().c_str());
         *offset = -1;
         return false;
     }
-    std::pair<int,DVEntry>&  p = (*dv_entries)[key];
-    *offset = p.first;
+    *offset = dve->offset;
 
-    return p.second.extractReadableString(out);
+    return dve->extractReadableString(out);
 }
 
 bool DVEntry::extractReadableString(std::string *out)
 {
     int t = dif_vif_key.dif() & 0xf;
 
-    std::string v = value;
+    std::vector<uchar> v(value_bytes.begin(), value_bytes.end());
 
     if (t == 0x1 || // 8 Bit Integer/Binary
         t == 0x2 || // 16 Bit Integer/Binary
@@ -1166,18 +1196,18 @@ bool DVEntry::extractReadableString(std::string *out)
         t == 0x7 || // 64 Bit Integer/Binary
         t == 0xD)   // Variable length
     {
-        if (isLikelyAscii(v))
+        bool ascii = isLikelyAscii(v);
+        std::reverse(v.begin(), v.end());
+        if (ascii)
         {
             // For example an enhanced id 32 bits binary looks like:
             // 44434241 and will be reversed to: 41424344 and translated using ascii
             // to ABCD
-            v = reverseBinaryAsciiSafeToString(v);
-        }
-        else
-        {
-            v = reverseBCD(v);
+            *out = safeString(v);
+            return true;
         }
     }
+    else
     if (t == 0x9 || // 2 digit BCD
         t == 0xA || // 4 digit BCD
         t == 0xB || // 6 digit BCD
@@ -1186,10 +1216,10 @@ bool DVEntry::extractReadableString(std::string *out)
     {
         // For example an enhanced id 12 digit bcd looks like:
         // 618171183100 and will be reversed to: 003118718161
-        v = reverseBCD(v);
+        std::reverse(v.begin(), v.end());
     }
 
-    *out = v;
+    *out = bin2hex(v);
     return true;
 }
 
@@ -1206,6 +1236,11 @@ double DVEntry::getCounter(DVEntryCounterType ct)
     return std::numeric_limits<double>::quiet_NaN();
 }
 
+std::string DVEntry::valueHex() const
+{
+    return bin2hex((const uchar*)value_bytes.data(), value_bytes.size());
+}
+
 std::string DVEntry::str()
 {
     std::string s =
@@ -1258,22 +1293,22 @@ bool extractTime(uchar hi, uchar lo, struct tm *date)
     return true;
 }
 
-bool extractDVdate(std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
-                   std::string key,
+bool extractDVdate(DVEntries *dv_entries,
+                   const DifVifKey &key,
                    int *offset,
                    struct tm *out)
 {
-    if ((*dv_entries).count(key) == 0)
+    DVEntry *dve = dv_entries->find(key);
+    if (dve == NULL)
     {
-        verbose("(dvparser) warning: cannot extract date from non-existant key \"%s\"\n", key.c_str());
+        verbose("(dvparser) warning: cannot extract date from non-existant key \"%s\"\n", key.str().c_str());
         *offset = -1;
         memset(out, 0, sizeof(struct tm));
         return false;
     }
-    std::pair<int,DVEntry>&  p = (*dv_entries)[key];
-    *offset = p.first;
+    *offset = dve->offset;
 
-    return p.second.extractDate(out);
+    return dve->extractDate(out);
 }
 
 bool DVEntry::extractDate(struct tm *out)
@@ -1281,8 +1316,7 @@ bool DVEntry::extractDate(struct tm *out)
     memset(out, 0, sizeof(*out));
     out->tm_isdst = -1; // Figure out the dst automatically!
 
-    std::vector<uchar> v;
-    hex2bin(value, &v);
+    const std::string &v = value_bytes;
 
     bool ok = true;
     if (v.size() == 2) {
@@ -230,25 +230,37 @@ MeasurementType toMeasurementType(const char *s);
 
 void extractDV(std::string &s, uchar *dif, int *vif, bool *has_difes, bool *has_vifes);
 
+// The dif(difes)vif(vifes) bytes identifying a data record, written as hex like 0C13 or 8E10833C.
+// When the same difvif occurs several times in a telegram, the second one is 0C13_2 etc.
+// Keys up to 7 bytes (nearly all of them) are packed together with their length into a single integer,
+// so comparing and hashing keys never touches strings. Longer keys pack a hash and also compare the bytes.
 struct DifVifKey
 {
-    DifVifKey(std::string key) : key_(key) {
-        extractDV(key, &dif_, &vif_, &has_difes_, &has_vifes_);
-    }
-    std::string str() { return key_; }
-    bool operator==(DifVifKey &dvk) { return key_ == dvk.key_; }
-    uchar dif() { return dif_; }
-    int vif() { return vif_; }
-    bool hasDifes() { return has_difes_; }
-    bool hasVifes() { return has_vifes_; }
+    DifVifKey(const char *key);
+    DifVifKey(const std::string &key) : DifVifKey(key.c_str()) {}
+    DifVifKey(const std::vector<uchar> &difvif, int nr = 1);
+    std::string str() const;
+    bool operator==(const DifVifKey &dvk) const {
+        return packed_ == dvk.packed_ && nr_ == dvk.nr_ && (bytes_.size() <= 7 || bytes_ == dvk.bytes_); }
+    uchar dif() const { return dif_; }
+    int vif() const { return vif_; }
+    bool hasDifes() const { return has_difes_; }
+    bool hasVifes() const { return has_vifes_; }
+    uint64_t packed() const { return packed_; }
+    int nr() const { return nr_; }
+    size_t hash() const;
 
 private:
 
-    std::string key_;
-    uchar dif_;
-    int vif_;
-    bool has_difes_;
-    bool has_vifes_;
+    void init();
+
+    std::string bytes_; // Raw difvif bytes, short keys are stored inline.
+    uint64_t packed_ {};
+    int nr_ {1};
+    uchar dif_ {};
+    int vif_ {};
+    bool has_difes_ {};
+    bool has_vifes_ {};
 };
 
 void extractDV(DifVifKey &s, uchar *dif, int *vif, bool *has_difes, bool *has_vifes);
@@ -347,7 +359,9 @@ struct DVEntry
     StorageNr storage_nr;
     TariffNr tariff_nr;
     SubUnitNr subunit_nr;
-    std::string value;
+    // Raw record data as found in the telegram, not hex encoded. A std::string is used as
+    // byte container so that all fixed size records (max 8 bytes) are stored without heap allocation.
+    std::string value_bytes;
 
     DVEntry(int off,
             DifVifKey dvk,
@@ -358,7 +372,8 @@ struct DVEntry
             StorageNr st,
             TariffNr ta,
             SubUnitNr su,
-            std::string &val) :
+            const uchar *val,
+            size_t val_len) :
         offset(off),
         dif_vif_key(dvk),
         measurement_type(mt),
@@ -368,7 +383,7 @@ struct DVEntry
         storage_nr(st),
         tariff_nr(ta),
         subunit_nr(su),
-        value(val)
+        value_bytes(val, val + val_len)
     {
     }
 
@@ -379,8 +394,7 @@ struct DVEntry
         vif(0),
         storage_nr(0),
         tariff_nr(0),
-        subunit_nr(0),
-        value("x")
+        subunit_nr(0)
     {
     }
 
@@ -388,6 +402,10 @@ struct DVEntry
     bool extractLong(uint64_t *out);
     bool extractDate(struct tm *out);
     bool extractReadableString(std::string *out);
+    size_t valueSize() const { return value_bytes.size(); }
+    uchar valueByte(size_t i) const { return (uchar)value_bytes[i]; }
+    // Hex is only rendered on demand, for json and debug output.
+    std::string valueHex() const;
     void addFieldInfo(FieldInfo *fi) { field_infos_.insert(fi); }
     bool hasFieldInfo(FieldInfo *fi) { return field_infos_.count(fi) > 0; }
     std::string str();
@@ -398,6 +416,32 @@ private:
     std::set<FieldInfo*> field_infos_; // The field infos selected to decode this entry.
 };
 
+// All data records of a telegram, in the order they were found in the telegram.
+// Lookups by difvif key go through a small open addressing hash index instead of a tree of string keys.
+struct DVEntries
+{
+    typedef std::vector<DVEntry>::iterator iterator;
+
+    // Add an entry at the end, an existing entry with the same key is replaced.
+    DVEntry &add(DVEntry dve);
+    DVEntry *find(const DifVifKey &key);
+    bool has(const DifVifKey &key) { return find(key) != NULL; }
+    void clear();
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    DVEntry &operator[](size_t i) { return entries_[i]; }
+    iterator begin() { return entries_.begin(); }
+    iterator end() { return entries_.end(); }
+    // Hash of the sequence of difvif keys, telegrams with the same layout get the same hash.
+    uint64_t layoutHash() const;
+
+private:
+    void insertIndex(size_t entry);
+
+    std::vector<DVEntry> entries_;
+    std::vector<uint16_t> index_; // Entry position+1 for each slot, 0 marks a free slot.
+};
+
 struct FieldMatcher
 {
     // If not actually used, this remains false.
@@ -519,7 +563,7 @@ bool parseDV(Telegram *t,
              std::vector<uchar> &databytes,
              std::vector<uchar>::iterator data,
              size_t data_len,
-             std::map<std::string,std::pair<int,DVEntry>> *dv_entries,
+             DVEntries *dv_entries,
              std::vector<uchar>::iterator *format = NULL,
              size_t format_len = 0,
              uint16_t *format_hash = NULL);
@@ -529,64 +573,67 @@ bool parseDV(Telegram *t,
 // Like: Volume, VolumeFlow, FlowTemperature, ExternalTemperature etc
 // in combination with the storagenr. (Later I will add tariff/subunit)
 bool findKey(MeasurementType mt, VIFRange vi, StorageNr storagenr, TariffNr tariffnr,
-             std::string *key, std::map<std::string,std::pair<int,DVEntry>> *values);
+             std::string *key, DVEntries *values);
 // Some meters have multiple identical DIF/VIF values! Meh, they are not using storage nrs or tariff nrs.
 // So here we can pick for example nr 2 of an identical set if DIF/VIF values.
 // Nr 1 means the first found value.
 bool findKeyWithNr(MeasurementType mt, VIFRange vi, StorageNr storagenr, TariffNr tariffnr, int indexnr,
-                   std::string *key, std::map<std::string,std::pair<int,DVEntry>> *values);
+                   std::string *key, DVEntries *values);
+// Same as above but returns the entry itself, or NULL if none was found.
+DVEntry *findEntryWithNr(MeasurementType mt, VIFRange vi, StorageNr storagenr, TariffNr tariffnr, int indexnr,
+                         DVEntries *values);
 
-bool hasKey(std::map<std::string,std::pair<int,DVEntry>> *values, std::string key);
+bool hasKey(DVEntries *values, const DifVifKey &key);
 
-bool extractDVuint8(std::map<std::string,std::pair<int,DVEntry>> *values,
-                    std::string key,
+bool extractDVuint8(DVEntries *values,
+                    const DifVifKey &key,
                     int *offset,
                     uchar *value);
 
-bool extractDVuint16(std::map<std::string,std::pair<int,DVEntry>> *values,
-                     std::string key,
+bool extractDVuint16(DVEntries *values,
+                     const DifVifKey &key,
                      int *offset,
                      uint16_t *value);
 
-bool extractDVuint24(std::map<std::string,std::pair<int,DVEntry>> *values,
-                     std::string key,
+bool extractDVuint24(DVEntries *values,
+                     const DifVifKey &key,
                      int *offset,
                      uint32_t *value);
 
-bool extractDVuint32(std::map<std::string,std::pair<int,DVEntry>> *values,
-                     std::string key,
+bool extractDVuint32(DVEntries *values,
+                     const DifVifKey &key,
                      int *offset,
                      uint32_t *value);
 
 // All values are scaled according to the vif and wmbusmeters scaling defaults.
-bool extractDVdouble(std::map<std::string,std::pair<int,DVEntry>> *values,
-                     std::string key,
+bool extractDVdouble(DVEntries *values,
+                     const DifVifKey &key,
                      int *offset,
                      double *value,
                      bool auto_scale = true,
                      bool force_unsigned = false);
 
 // Extract a value without scaling. Works for 8bits to 64 bits, binary and bcd.
-bool extractDVlong(std::map<std::string,std::pair<int,DVEntry>> *values,
-                   std::string key,
+bool extractDVlong(DVEntries *values,
+                   const DifVifKey &key,
                    int *offset,
                    uint64_t *value);
 
 // Just copy the raw hex data into the std::string, not reversed or anything.
-bool extractDVHexString(std::map<std::string,std::pair<int,DVEntry>> *values,
-                        std::string key,
+bool extractDVHexString(DVEntries *values,
+                        const DifVifKey &key,
                         int *offset,
                         std::string *value);
 
 // Read the content and attempt to reverse and transform it into a readble std::string
 // based on the dif information.
-bool extractDVReadableString(std::map<std::string,std::pair<int,DVEntry>> *values,
-                             std::string key,
+bool extractDVReadableString(DVEntries *values,
+                             const DifVifKey &key,
                              int *offset,
                              std::string *value);
 
-bool extractDVdate(std::map<std::string,std::pair<int,DVEntry>> *values,
-                   std::string key,
+bool extractDVdate(DVEntries *values,
+                   const DifVifKey &key,
                    int *offset,
                    struct tm *value);
 
@@ -18,6 +18,7 @@
 #include"formula.h"
 #include"formula_implementation.h"
 #include"meters.h"
+#include"meters_common_implementation.h"
 #include"units.h"
 
 #include<cmath>
@@ -177,6 +178,87 @@ double NumericFormulaSquareRoot::calculate(SIUnit to_siunit)
     return v;
 }
 
+void NumericFormula::compile(SIUnit to)
+{
+    if (isConstant())
+    {
+        formula()->emitOp(FormulaOp::PUSH, calculate(to));
+        return;
+    }
+    emit(to);
+}
+
+void NumericFormulaConstant::emit(SIUnit to)
+{
+    formula()->emitOp(FormulaOp::PUSH, calculate(to));
+}
+
+void NumericFormulaMeterField::emit(SIUnit to_si_unit)
+{
+    FieldInfo *fi = NULL;
+    if (formula()->meter() != NULL) fi = formula()->meter()->findFieldInfo(vname_, quantity_);
+
+    if (fi == NULL)
+    {
+        formula()->emitOp(FormulaOp::PUSH, std::numeric_limits<double>::quiet_NaN());
+        return;
+    }
+
+    formula()->emitOp(FormulaOp::LOAD_FIELD, 0, 0, formula()->fieldSlot(fi));
+    formula()->emitConversion(toSIUnit(fi->displayUnit()), to_si_unit);
+}
+
+void NumericFormulaDVEntryField::emit(SIUnit to_si_unit)
+{
+    formula()->emitOp(FormulaOp::LOAD_COUNTER, 0, 0, (int)counter_);
+    formula()->emitConversion(toSIUnit(Unit::COUNTER), to_si_unit);
+}
+
+void NumericFormulaAddition::emit(SIUnit to_siunit)
+{
+    SIUnit v_siunit(Unit::COUNTER);
+    formula()->emitMathOp(MathOp::ADD, left_.get(), right_.get(), &v_siunit);
+    formula()->emitConversion(v_siunit, to_siunit);
+}
+
+void NumericFormulaSubtraction::emit(SIUnit to_siunit)
+{
+    SIUnit v_siunit(Unit::COUNTER);
+    formula()->emitMathOp(MathOp::SUB, left_.get(), right_.get(), &v_siunit);
+    formula()->emitConversion(v_siunit, to_siunit);
+}
+
+void NumericFormulaMultiplication::emit(SIUnit to_siunit)
+{
+    left_->compile(left_->siunit());
+    right_->compile(right_->siunit());
+    formula()->emitOp(FormulaOp::MUL);
+    formula()->emitConversion(siunit(), to_siunit);
+}
+
+void NumericFormulaDivision::emit(SIUnit to_siunit)
+{
+    left_->compile(left_->siunit());
+    right_->compile(right_->siunit());
+    formula()->emitOp(FormulaOp::DIV);
+    formula()->emitConversion(siunit(), to_siunit);
+}
+
+void NumericFormulaExponentiation::emit(SIUnit to_siunit)
+{
+    left_->compile(to_siunit);
+    right_->compile(to_siunit);
+    formula()->emitOp(FormulaOp::POW);
+    formula()->emitConversion(siunit(), to_siunit);
+}
+
+void NumericFormulaSquareRoot::emit(SIUnit to_siunit)
+{
+    inner_->compile(inner_->siunit());
+    formula()->emitOp(FormulaOp::SQRT);
+    formula()->emitConversion(siunit(), to_siunit);
+}
+
 const char *toString(TokenType tt)
 {
     switch (tt) {
@@ -253,6 +335,10 @@ void FormulaImplementation::clear()
     formula_ = "";
     dventry_ = NULL;
     meter_ = NULL;
+    compiled_ = false;
+    program_.clear();
+    field_slots_.clear();
+    conversions_.clear();
 }
 
 bool is_letter(char c)
@@ -933,9 +1019,221 @@ double FormulaImplementation::calculate(Unit to, DVEntry *dve, Meter *m)
         return std::nan("");
     }
 
+    if (!compiled_ || compiled_to_ != to || compiled_meter_ != meter_) compile(to);
+
+    return run();
+}
+
+double FormulaImplementation::calculateTree(Unit to, DVEntry *dve, Meter *m)
+{
+    if (dve != NULL) dventry_ = dve;
+    if (m != NULL) meter_ = m;
+
+    if (!valid_ || op_stack_.size() != 1) return std::nan("");
+
     return topOp()->calculate(toSIUnit(to));
 }
 
+void FormulaImplementation::compile(Unit to)
+{
+    program_.clear();
+    field_slots_.clear();
+    conversions_.clear();
+    stack_depth_ = 0;
+    stack_.clear();
+
+    topOp()->compile(toSIUnit(to));
+
+    compiled_ = true;
+    compiled_to_ = to;
+    compiled_meter_ = meter_;
+
+    debug("(formula) compiled %s into %zu instructions\n", tree().c_str(), program_.size());
+}
+
+double FormulaImplementation::run()
+{
+    // sp points to the first free entry on the stack.
+    double *sp = &stack_[0];
+
+    for (const FormulaInstruction &i : program_)
+    {
+        switch (i.op)
+        {
+        case FormulaOp::PUSH: *sp++ = i.a; break;
+        case FormulaOp::LOAD_FIELD: *sp++ = loadField(i.slot); break;
+        case FormulaOp::LOAD_COUNTER:
+            if (dventry_ == NULL) *sp++ = std::numeric_limits<double>::quiet_NaN();
+            else *sp++ = dventry_->getCounter((DVEntryCounterType)i.slot);
+            break;
+        case FormulaOp::SCALE: sp[-1] = (sp[-1]*i.a)/i.b; break;
+        case FormulaOp::CONVERT: conversions_[i.slot].first.convertTo(sp[-1], conversions_[i.slot].second, &sp[-1]); break;
+        case FormulaOp::REPLACE: sp[-1] = i.a; break;
+        case FormulaOp::REPLACE2: sp--; sp[-1] = i.a; break;
+        case FormulaOp::NEG: sp[-1] = -sp[-1]; break;
+        case FormulaOp::ADD: sp--; sp[-1] = sp[-1]+sp[0]; break;
+        case FormulaOp::SUB: sp--; sp[-1] = sp[-1]-sp[0]; break;
+        case FormulaOp::SUB_REVERSED: sp--; sp[-1] = sp[0]-sp[-1]; break;
+        case FormulaOp::MUL: sp--; sp[-1] = sp[-1]*sp[0]; break;
+        case FormulaOp::DIV: sp--; sp[-1] = sp[-1]/sp[0]; break;
+        case FormulaOp::POW: sp--; sp[-1] = pow(sp[-1], sp[0]); break;
+        case FormulaOp::SQRT: sp[-1] = sqrt(sp[-1]); break;
+        case FormulaOp::ADD_MONTHS: sp--; sp[-1] = addMonths(sp[-1], sp[0]); break;
+        case FormulaOp::ADD_MONTHS_REVERSED: sp--; sp[-1] = addMonths(sp[0], sp[-1]); break;
+        }
+    }
+
+    return sp[-1];
+}
+
+void FormulaImplementation::emitOp(FormulaOp op, double a, double b, int slot)
+{
+    program_.push_back({op, slot, a, b});
+
+    switch (op)
+    {
+    case FormulaOp::PUSH:
+    case FormulaOp::LOAD_FIELD:
+    case FormulaOp::LOAD_COUNTER:
+        stack_depth_++;
+        if (stack_depth_ > stack_.size()) stack_.resize(stack_depth_);
+        break;
+    case FormulaOp::REPLACE2:
+    case FormulaOp::ADD:
+    case FormulaOp::SUB:
+    case FormulaOp::SUB_REVERSED:
+    case FormulaOp::MUL:
+    case FormulaOp::DIV:
+    case FormulaOp::POW:
+    case FormulaOp::ADD_MONTHS:
+    case FormulaOp::ADD_MONTHS_REVERSED:
+        assert(stack_depth_ >= 2);
+        stack_depth_--;
+        break;
+    default:
+        break;
+    }
+}
+
+void FormulaImplementation::emitConversion(const SIUnit &from, const SIUnit &to)
+{
+    if (from.exp().equalIgnoreNonLinear(to.exp()) && from.exp().isLinear() && to.exp().isLinear())
+    {
+        // (v*1.0)/1.0 is always v, no need to scale.
+        if (from.scale() == 1.0 && to.scale() == 1.0) return;
+        emitOp(FormulaOp::SCALE, from.scale(), to.scale());
+        return;
+    }
+
+    if (from.exp().equalIgnoreNonLinear(to.exp()) || (isKCF(from.exp()) && isKCF(to.exp())))
+    {
+        conversions_.push_back({from, to});
+        emitOp(FormulaOp::CONVERT, 0, 0, conversions_.size()-1);
+        return;
+    }
+
+    // The conversion is impossible.
+    emitOp(FormulaOp::REPLACE, std::numeric_limits<double>::quiet_NaN());
+}
+
+void FormulaImplementation::emitMathOp(MathOp op, NumericFormula *left, NumericFormula *right, SIUnit *out_siunit)
+{
+    const SIExp &left_exp = left->siunit().exp();
+    const SIExp &right_exp = right->siunit().exp();
+    const SIExp &timestamp_exp = SI_UnixTimestamp.exp();
+
+    // The left value is converted right after it has been pushed, it is independent of the right value.
+    left->compile(left->siunit());
+
+    if (left_exp == right_exp && op == MathOp::ADD && left_exp == timestamp_exp)
+    {
+        // Two unix timestamps cannot be added together.
+        right->compile(right->siunit());
+        emitOp(FormulaOp::REPLACE2, std::numeric_limits<double>::quiet_NaN());
+        *out_siunit = SI_COUNTER;
+        return;
+    }
+
+    if (left_exp == right_exp || (isKCF(left_exp) && isKCF(right_exp)))
+    {
+        // Same units or temperatures, the left value is converted into the right unit.
+        emitConversion(left->siunit(), right->siunit());
+        right->compile(right->siunit());
+        emitOp(op == MathOp::ADD ? FormulaOp::ADD : FormulaOp::SUB);
+        *out_siunit = right->siunit();
+        return;
+    }
+
+    if (right_exp == timestamp_exp)
+    {
+        // The timestamp is right, mathOpTo flips the arguments.
+        if (left_exp == SI_Second.exp())
+        {
+            emitConversion(left->siunit(), SI_Second);
+            right->compile(right->siunit());
+            emitOp(op == MathOp::ADD ? FormulaOp::ADD : FormulaOp::SUB_REVERSED);
+            *out_siunit = SI_UnixTimestamp;
+            return;
+        }
+        if (left_exp == SI_Month.exp())
+        {
+            if (op == MathOp::SUB) emitOp(FormulaOp::NEG);
+            right->compile(right->siunit());
+            emitOp(FormulaOp::ADD_MONTHS_REVERSED);
+            *out_siunit = SI_UnixTimestamp;
+            return;
+        }
+    }
+
+    right->compile(right->siunit());
+
+    if (left_exp == timestamp_exp)
+    {
+        if (right_exp == SI_Second.exp())
+        {
+            emitConversion(right->siunit(), SI_Second);
+            emitOp(op == MathOp::ADD ? FormulaOp::ADD : FormulaOp::SUB);
+            *out_siunit = SI_UnixTimestamp;
+            return;
+        }
+        if (right_exp == SI_Month.exp())
+        {
+            if (op == MathOp::SUB) emitOp(FormulaOp::NEG);
+            emitOp(FormulaOp::ADD_MONTHS);
+            *out_siunit = SI_UnixTimestamp;
+            return;
+        }
+    }
+
+    // The values cannot be added or subtracted, mathOpTo leaves a zero counter.
+    emitOp(FormulaOp::REPLACE2, 0);
+    *out_siunit = SI_COUNTER;
+}
+
+int FormulaImplementation::fieldSlot(FieldInfo *fi)
+{
+    size_t field_index = fi - &meter_->fieldInfos()[0];
+
+    for (size_t i = 0; i < field_slots_.size(); ++i)
+    {
+        if (field_slots_[i].field_index == field_index) return i;
+    }
+    field_slots_.push_back({field_index, fi->displayUnit(), NULL});
+    return field_slots_.size()-1;
+}
+
+double FormulaImplementation::loadField(int slot)
+{
+    FormulaFieldSlot &fs = field_slots_[slot];
+
+    if (fs.storage == NULL)
+    {
+        fs.storage = meter_->numericFieldStorage(&meter_->fieldInfos()[fs.field_index]);
+        if (fs.storage == NULL) return std::numeric_limits<double>::quiet_NaN(); // Not yet set.
+    }
+    return convert(fs.storage->value, fs.storage->unit, fs.display_unit);
+}
+
 void FormulaImplementation::doConstant(Unit u, double c)
 {
     pushOp(new NumericFormulaConstant(this, u, c));
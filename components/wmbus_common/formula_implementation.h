@@ -31,6 +31,12 @@ struct NumericFormula
     SIUnit &siunit() { return siunit_; }
     // Calculate the formula and return the value in the given "to" unit.
     virtual double calculate(SIUnit to) = 0;
+    // True if the formula reads neither meter fields nor dventry counters.
+    virtual bool isConstant() = 0;
+    // Append instructions to the compiled program that leave the value in the given "to" unit on the stack.
+    // A constant formula is folded into a single push of its calculated value.
+    void compile(SIUnit to);
+    virtual void emit(SIUnit to) = 0;
     virtual std::string str() = 0;
     virtual std::string tree() = 0;
     virtual ~NumericFormula() = 0;
@@ -47,6 +53,8 @@ struct NumericFormulaConstant : public NumericFormula
 {
     NumericFormulaConstant(FormulaImplementation *f, Unit u, double c) : NumericFormula(f, u), constant_(c) {}
     double calculate(SIUnit to);
+    bool isConstant() { return true; }
+    void emit(SIUnit to);
     std::string str();
     std::string tree();
     ~NumericFormulaConstant();
@@ -62,6 +70,8 @@ struct NumericFormulaMeterField : public NumericFormula
         : NumericFormula(f, u), vname_(v), quantity_(q) {}
 
     double calculate(SIUnit to);
+    bool isConstant() { return false; }
+    void emit(SIUnit to);
     std::string str();
     std::string tree();
     ~NumericFormulaMeterField();
@@ -77,6 +87,8 @@ struct NumericFormulaDVEntryField : public NumericFormula
     NumericFormulaDVEntryField(FormulaImplementation *f, Unit u, DVEntryCounterType ct) : NumericFormula(f, u), counter_(ct) {}
 
     double calculate(SIUnit to);
+    bool isConstant() { return false; }
+    void emit(SIUnit to);
     std::string str();
     std::string tree();
     ~NumericFormulaDVEntryField();
@@ -99,6 +111,7 @@ struct NumericFormulaPair : public NumericFormula
         op_(op)
     {}
 
+    bool isConstant() { return left_->isConstant() && right_->isConstant(); }
     std::string str();
     std::string tree();
     ~NumericFormulaPair();
@@ -119,6 +132,7 @@ struct NumericFormulaAddition : public NumericFormulaPair
         : NumericFormulaPair(f, siu, a, b, "ADD", "+") {}
 
     double calculate(SIUnit to);
+    void emit(SIUnit to);
 
     ~NumericFormulaAddition();
 };
@@ -131,6 +145,7 @@ struct NumericFormulaSubtraction : public NumericFormulaPair
         : NumericFormulaPair(f, siu, a, b, "SUB", "-") {}
 
     double calculate(SIUnit to);
+    void emit(SIUnit to);
 
     ~NumericFormulaSubtraction();
 };
@@ -143,6 +158,7 @@ struct NumericFormulaMultiplication : public NumericFormulaPair
         : NumericFormulaPair(f, siu, a, b, "TIMES", "×") {}
 
     double calculate(SIUnit to);
+    void emit(SIUnit to);
 
     ~NumericFormulaMultiplication();
 };
@@ -155,6 +171,7 @@ struct NumericFormulaDivision : public NumericFormulaPair
         : NumericFormulaPair(f, siu, a, b, "DIV", "÷") {}
 
     double calculate(SIUnit to);
+    void emit(SIUnit to);
 
     ~NumericFormulaDivision();
 };
@@ -167,6 +184,7 @@ struct NumericFormulaExponentiation : public NumericFormulaPair
         : NumericFormulaPair(f, siu, a, b, "EXP", "^") {}
 
     double calculate(SIUnit to);
+    void emit(SIUnit to);
 
     ~NumericFormulaExponentiation();
 };
@@ -178,6 +196,8 @@ struct NumericFormulaSquareRoot : public NumericFormula
         : NumericFormula(f, siu), inner_(std::move(inner)) {}
 
     double calculate(SIUnit to);
+    bool isConstant() { return inner_->isConstant(); }
+    void emit(SIUnit to);
     std::string str();
     std::string tree();
 
@@ -188,6 +208,46 @@ private:
     std::unique_ptr<NumericFormula> inner_;
 };
 
+// The instructions of a compiled formula. They operate on a stack of doubles,
+// top is the last pushed value and next is the value below it.
+enum class FormulaOp
+{
+    PUSH,                // Push a.
+    LOAD_FIELD,          // Push the value of the meter field in field slot, in the field's display unit.
+    LOAD_COUNTER,        // Push the dventry counter, slot is the DVEntryCounterType.
+    SCALE,               // top = (top*a)/b, a linear unit conversion.
+    CONVERT,             // Convert top with the unit conversion in slot, for non-linear and temperature units.
+    REPLACE,             // top = a
+    REPLACE2,            // Pop top, next = a
+    NEG,                 // top = -top
+    ADD,                 // Pop top, next = next+top
+    SUB,                 // Pop top, next = next-top
+    SUB_REVERSED,        // Pop top, next = top-next
+    MUL,                 // Pop top, next = next*top
+    DIV,                 // Pop top, next = next/top
+    POW,                 // Pop top, next = pow(next,top)
+    SQRT,                // top = sqrt(top)
+    ADD_MONTHS,          // Pop top, next = addMonths(next,top)
+    ADD_MONTHS_REVERSED, // Pop top, next = addMonths(top,next)
+};
+
+struct FormulaInstruction
+{
+    FormulaOp op;
+    int slot;
+    double a;
+    double b;
+};
+
+// A meter field read by the compiled formula. The storage of the field value is looked
+// up the first time the value exists and is then reused.
+struct FormulaFieldSlot
+{
+    size_t field_index; // Into the meter fieldInfos.
+    Unit display_unit;
+    NumericField *storage;
+};
+
 enum class TokenType
 {
     SPACE,
@@ -262,6 +322,27 @@ struct FormulaImplementation : public Formula
     // The target unit will be SIUnit square rooted.
     void doSquareRoot();
 
+    // Calculate by walking the tree, like calculate did before formulas were compiled.
+    // Used to check that the compiled program gives identical results.
+    double calculateTree(Unit to, DVEntry *dve = NULL, Meter *m = NULL);
+    // Compile the parsed tree into a flat program that calculates the formula in the given unit
+    // for the current meter. The program gives the same results as calculating the tree, but
+    // without field name lookups and virtual calls for every calculation.
+    void compile(Unit to);
+    // Run the compiled program.
+    double run();
+    // Append an instruction to the compiled program.
+    void emitOp(FormulaOp op, double a = 0, double b = 0, int slot = 0);
+    // Append the instructions, if any, that convert the top of the stack between the units.
+    // The same conversion as SIUnit::convertTo, with the linear factors picked at compile time.
+    void emitConversion(const SIUnit &from, const SIUnit &to);
+    // Append the instructions that add or subtract the left and right formulas the way
+    // SIUnit::mathOpTo does it. The unit of the result is stored into out_siunit.
+    void emitMathOp(MathOp op, NumericFormula *left, NumericFormula *right, SIUnit *out_siunit);
+    // Return the field slot for reading the given meter field.
+    int fieldSlot(FieldInfo *fi);
+    double loadField(int slot);
+
     ~FormulaImplementation();
 
     bool tokenize();
@@ -313,6 +394,16 @@ private:
     Meter *meter_; // To be referenced when parsing and calculating.
     DVEntry *dventry_; // To be referenced when calculating.
 
+    // The compiled program, valid for calculating into compiled_to_ with compiled_meter_.
+    bool compiled_ = false;
+    Unit compiled_to_ {};
+    Meter *compiled_meter_ {};
+    std::vector<FormulaInstruction> program_;
+    std::vector<FormulaFieldSlot> field_slots_;
+    std::vector<std::pair<SIUnit,SIUnit>> conversions_;
+    size_t stack_depth_ {};
+    std::vector<double> stack_; // Sized to the max depth of the program.
+
     // Any errors during parsing are store here.
     std::vector<std::string> errors_;
 };
@@ -349,7 +349,7 @@ const char *toString(DiehlAddressTransformMethod m)
 }
 
 void qdsExtractWalkByField(Telegram *t, Meter *driver, DVEntry &mfctEntry, int pos, int n, const std::string &key_s, const std::string &fieldName, Quantity quantity) {
-    std::string bytes = mfctEntry.value.substr(pos, n);
+    const uchar *bytes = (const uchar*)mfctEntry.value_bytes.data() + pos;
 
     DifVifKey key(key_s);
     DVEntry fieldEntry(0,
@@ -361,7 +361,8 @@ void qdsExtractWalkByField(Telegram *t, Meter *driver, DVEntry &mfctEntry, int p
                        AnyStorageNr,
                        AnyTariffNr,
                        SubUnitNr(0),
-                       bytes);
+                       bytes,
+                       n);
 
     FieldInfo *fieldInfo = driver->findFieldInfo(fieldName, quantity);
     if (fieldInfo == nullptr) {
@@ -369,7 +370,7 @@ void qdsExtractWalkByField(Telegram *t, Meter *driver, DVEntry &mfctEntry, int p
     }
 
     fieldInfo->performExtraction(driver, t, &fieldEntry);
-    std::string info = "*** " + bytes + " (" + fieldInfo->renderJson(driver, &fieldEntry) + ")";
+    std::string info = "*** " + fieldEntry.valueHex() + " (" + fieldInfo->renderJson(driver, &fieldEntry) + ")";
 
-    t->addSpecialExplanation(mfctEntry.offset + pos / 2, n / 2, KindOfData::CONTENT, Understanding::FULL, info.c_str());
+    t->addSpecialExplanation(mfctEntry.offset + pos, n, KindOfData::CONTENT, Understanding::FULL, info.c_str());
 }
@@ -80,6 +80,7 @@ bool mustDecryptDiehlRealData(const std::vector<uchar>& frame);
 // Diehl: decrypt real data payload (LFSR)
 bool decryptDielhRealData(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, const std::vector<uchar> &meterkey);
 
+// Extract n bytes at byte offset pos of the manufacturer specific entry as a field with the given difvif key.
 void qdsExtractWalkByField(Telegram *t, Meter *driver, DVEntry &mfctEntry, int pos, int n, const std::string &key_s, const std::string &fieldName, Quantity quantity);
 
 #endif
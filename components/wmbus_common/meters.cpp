@@ -606,6 +606,16 @@ int MeterCommonImplementation::numUpdates()
     return num_updates_;
 }
 
+int MeterCommonImplementation::numExtractionPlanHits()
+{
+    return num_extraction_plan_hits_;
+}
+
+int MeterCommonImplementation::numExtractionPlanMisses()
+{
+    return num_extraction_plan_misses_;
+}
+
 std::string MeterCommonImplementation::datetimeOfUpdateHumanReadable()
 {
     char datetime[40];
@@ -957,7 +967,7 @@ std::string concatFields(Meter *m, Telegram *t, char c, std::vector<FieldInfo> &
     return buf;
 }
 
-bool MeterCommonImplementation::handleTelegram(AboutTelegram &about, std::vector<uchar> input_frame,
+bool MeterCommonImplementation::handleTelegram(AboutTelegram &about, const std::vector<uchar> &input_frame,
                                                bool simulated, std::vector<Address> *addresses,
                                                bool *id_match, Telegram *out_analyzed)
 {
@@ -984,8 +994,7 @@ bool MeterCommonImplementation::handleTelegram(AboutTelegram &about, std::vector
             driverName().str().c_str(),
             t.addresses.back().str().c_str());
     
-    std::string msg = bin2hex(input_frame);
-    debug("(meter) %s %s \"%s\"\n", name().c_str(), t.addresses.back().str().c_str(), msg.c_str());
+    debug("(meter) %s %s \"%s\"\n", name().c_str(), t.addresses.back().str().c_str(), bin2hex(input_frame).c_str());
 
     // For older meters with manufacturer specific data without a nice 0f dif marker.
     if (force_mfct_index_ != -1)
@@ -996,7 +1005,7 @@ bool MeterCommonImplementation::handleTelegram(AboutTelegram &about, std::vector
     ok = t.parse(input_frame, &meter_keys_, true);
     if (!ok)
     {
-        if (out_analyzed != NULL) *out_analyzed = t;
+        if (out_analyzed != NULL) *out_analyzed = std::move(t);
         // Ignoring telegram since it could not be parsed.
         return false;
     }
@@ -1022,29 +1031,96 @@ bool MeterCommonImplementation::handleTelegram(AboutTelegram &about, std::vector
 
     triggerUpdate(&t);
 
-    if (out_analyzed != NULL) *out_analyzed = t;
+    if (out_analyzed != NULL) *out_analyzed = std::move(t);
     return true;
 }
 
 void MeterCommonImplementation::processFieldExtractors(Telegram *t)
 {
-    // Multiple dventries can be matched against a single wildcard FieldInfo.
-    std::map<FieldInfo*,std::set<DVEntry*>> founds;
+    // A meter sends the same layout of dv entries telegram after telegram. Only match the field infos
+    // against the dv entries the first time a layout is seen and then replay the remembered plan.
+    uint64_t layout_hash = t->dv_entries.layoutHash();
+    ExtractionPlan *plan = findExtractionPlan(t, layout_hash);
+    ExtractionPlan new_plan;
 
-    // Sort the dv_entries based on their offset in the telegram.
-    // I.e. restore the ordering that was implicit in the telegram.
-    std::vector<DVEntry*> sorted_entries;
+    if (plan != NULL)
+    {
+        num_extraction_plan_hits_++;
+        for (auto &step : plan->steps)
+        {
+            FieldInfo &fi = field_infos_[step.first];
+            DVEntry *dve = &t->dv_entries[step.second];
 
-    for (auto &p : t->dv_entries)
+            dve->addFieldInfo(&fi);
+            fi.performExtraction(this, t, dve);
+        }
+    }
+    else
     {
-        sorted_entries.push_back(&p.second.second);
+        num_extraction_plan_misses_++;
+        new_plan.layout_hash = layout_hash;
+        buildExtractionPlan(t, &new_plan);
+        plan = &new_plan;
+        // A telegram without dv entries (e.g. failed decryption) is not worth a plan slot.
+        if (!t->dv_entries.empty())
+        {
+            if (extraction_plans_.size() < MAX_EXTRACTION_PLANS)
+            {
+                extraction_plans_.push_back(std::move(new_plan));
+                plan = &extraction_plans_.back();
+            }
+            else
+            {
+                extraction_plans_[next_extraction_plan_] = std::move(new_plan);
+                plan = &extraction_plans_[next_extraction_plan_];
+                next_extraction_plan_ = (next_extraction_plan_+1) % MAX_EXTRACTION_PLANS;
+            }
+        }
     }
-    sort(sorted_entries.begin(), sorted_entries.end(),
-         [](const DVEntry* a, const DVEntry *b) -> bool { return a->offset < b->offset; });
+
+    // Iterate over the fields that has no matcher rule. Ie the field
+    // itself does the searching and matching.
+    for (size_t i = 0; i < field_infos_.size(); ++i)
+    {
+        FieldInfo &fi = field_infos_[i];
+        if (!fi.hasMatcher())
+        {
+            fi.performExtraction(this, t, NULL);
+        }
+        else if (!plan->matched[i] && fi.printProperties().hasINCLUDETPLSTATUS())
+        {
+            // This is a status field and it joins the tpl status but it also
+            // has a potential dve match, which did not trigger. Now
+            // force extraction to get the tpl status.
+            fi.performExtraction(this, t, NULL);
+        }
+    }
+}
+
+MeterCommonImplementation::ExtractionPlan *MeterCommonImplementation::findExtractionPlan(Telegram *t, uint64_t layout_hash)
+{
+    for (ExtractionPlan &plan : extraction_plans_)
+    {
+        if (plan.layout_hash == layout_hash &&
+            plan.num_entries == t->dv_entries.size() &&
+            plan.num_fields == field_infos_.size())
+        {
+            return &plan;
+        }
+    }
+    return NULL;
+}
+
+void MeterCommonImplementation::buildExtractionPlan(Telegram *t, ExtractionPlan *plan)
+{
+    plan->num_entries = t->dv_entries.size();
+    plan->num_fields = field_infos_.size();
+    plan->matched.assign(field_infos_.size(), false);
 
     // Now go through each field_info defined by the driver.
-    for (FieldInfo &fi : field_infos_)
+    for (size_t i = 0; i < field_infos_.size(); ++i)
     {
+        FieldInfo &fi = field_infos_[i];
         int current_match_nr = 0;
 
         if (!fi.hasMatcher())
@@ -1063,9 +1139,11 @@ void MeterCommonImplementation::processFieldExtractors(Telegram *t)
               fi.index());
 
         // Iterate through dv_entries in the telegram in the same order the telegram presented them.
-        for (DVEntry *dve : sorted_entries)
+        // Each dv entry is visited once per field info, so a field info can never match the same entry twice.
+        for (size_t j = 0; j < t->dv_entries.size(); ++j)
         {
-            if (fi.hasMatcher() && fi.matches(dve))
+            DVEntry *dve = &t->dv_entries[j];
+            if (fi.matches(dve))
             {
                 current_match_nr++;
                 if (fi.matcher().index_nr != IndexNr(current_match_nr) &&
@@ -1073,55 +1151,21 @@ void MeterCommonImplementation::processFieldExtractors(Telegram *t)
                 {
                     // This field info did match, but requires another index nr!
                     // Increment the current index nr and look for the next match.
+                    continue;
                 }
-                else if (founds[&fi].count(dve) == 0 || fi.matcher().expectedToMatchAgainstMultipleEntries())
-                {
-                    debug("(meters) using field info %s(%s)[%d] to extract %s at offset %d\n",
-                          fi.vname().c_str(),
-                          toString(fi.xuantity()),
-                          fi.index(),
-                          dve->dif_vif_key.str().c_str(),
-                          dve->offset);
-
-                    dve->addFieldInfo(&fi);
-                    fi.performExtraction(this, t, dve);
-                    founds[&fi].insert(dve);
-                }
-                else
-                {
-                    std::set<DVEntry*> old = founds[&fi];
-                    std::string olds;
-                    for (DVEntry *dve : old)
-                    {
-                        olds += std::to_string(dve->offset)+",";
-                    }
-                    olds.pop_back();
-
-                    verbose("(meter) while processing field extractors ignoring dventry %s at offset %d matching since "
-                            "field %s was already matched against offsets %s !\n",
-                            dve->dif_vif_key.str().c_str(),
-                            dve->offset,
-                            fi.vname().c_str(),
-                            olds.c_str());   
-                }
-            }
-        }
-    }
 
-    // Iterate over the fields that has no matcher rule. Ie the field
-    // itself does the searching and matching.
-    for (FieldInfo &fi : field_infos_)
-    {
-        if (!fi.hasMatcher())
-        {
-            fi.performExtraction(this, t, NULL);
-        }
-        else if (founds.count(&fi) == 0 && fi.printProperties().hasINCLUDETPLSTATUS())
-        {
-            // This is a status field and it joins the tpl status but it also
-            // has a potential dve match, which did not trigger. Now
-            // force extraction to get the tpl status.
-            fi.performExtraction(this, t, NULL);
+                debug("(meters) using field info %s(%s)[%d] to extract %s at offset %d\n",
+                      fi.vname().c_str(),
+                      toString(fi.xuantity()),
+                      fi.index(),
+                      dve->dif_vif_key.str().c_str(),
+                      dve->offset);
+
+                dve->addFieldInfo(&fi);
+                fi.performExtraction(this, t, dve);
+                plan->steps.push_back({ (uint16_t)i, (uint16_t)j });
+                plan->matched[i] = true;
+            }
         }
     }
 }
@@ -1243,6 +1287,13 @@ double MeterCommonImplementation::getNumericValue(FieldInfo *fi, Unit to)
     return convert(nf.value, nf.unit, to);
 }
 
+NumericField *MeterCommonImplementation::numericFieldStorage(FieldInfo *fi)
+{
+    auto i = numeric_values_.find(std::pair<std::string,Unit>(fi->vname(), fi->displayUnit()));
+    if (i == numeric_values_.end()) return NULL;
+    return &i->second;
+}
+
 double MeterCommonImplementation::getNumericValue(std::string vname, Unit to)
 {
     std::pair<std::string,Unit> key(vname,to);
@@ -2018,29 +2069,28 @@ DriverName MeterInfo::driverName()
 bool FieldInfo::extractNumeric(Meter *m, Telegram *t, DVEntry *dve)
 {
     bool found = false;
-    std::string key = matcher_.dif_vif_key.str();
 
     if (dve == NULL)
     {
-        if (key == "")
+        if (!matcher_.match_dif_vif_key)
         {
             // Search for key.
-            bool ok = findKeyWithNr(matcher_.measurement_type,
-                                    matcher_.vif_range,
-                                    matcher_.storage_nr_from.intValue(),
-                                    matcher_.tariff_nr_from.intValue(),
-                                    matcher_.index_nr.intValue(),
-                                    &key,
-                                    &t->dv_entries);
-            // No entry was found.
-            if (!ok) return false;
+            dve = findEntryWithNr(matcher_.measurement_type,
+                                  matcher_.vif_range,
+                                  matcher_.storage_nr_from.intValue(),
+                                  matcher_.tariff_nr_from.intValue(),
+                                  matcher_.index_nr.intValue(),
+                                  &t->dv_entries);
+        }
+        else
+        {
+            dve = t->dv_entries.find(matcher_.dif_vif_key);
         }
-        // No entry with this key was found.
-        if (t->dv_entries.count(key) == 0) return false;
-        dve = &t->dv_entries[key].second;
+        // No entry was found.
+        if (dve == NULL) return false;
     }
     assert(dve != NULL);
-    assert(key == "" || dve->dif_vif_key.str() == key);
+    assert(!matcher_.match_dif_vif_key || dve->dif_vif_key == matcher_.dif_vif_key);
 
     std::string field_name = generateFieldNameWithUnit(m, dve);
 
@@ -2138,11 +2188,10 @@ static std::string add_tpl_status(std::string existing_status, Meter *m, Telegra
 bool FieldInfo::extractString(Meter *m, Telegram *t, DVEntry *dve)
 {
     bool found = false;
-    std::string key = matcher_.dif_vif_key.str();
 
     if (dve == NULL)
     {
-        if (key == "")
+        if (!matcher_.match_dif_vif_key)
         {
             if (!hasMatcher())
             {
@@ -2157,28 +2206,20 @@ bool FieldInfo::extractString(Meter *m, Telegram *t, DVEntry *dve)
             else
             {
                 // Search for key.
-                bool ok = findKeyWithNr(matcher_.measurement_type,
-                                        matcher_.vif_range,
-                                        matcher_.storage_nr_from.intValue(),
-                                        matcher_.tariff_nr_from.intValue(),
-                                        matcher_.index_nr.intValue(),
-                                        &key,
-                                        &t->dv_entries);
-                // No entry was found.
-                if (!ok) {
-                    // Nothing found, however check if capturing JOIN_TPL_STATUS.
-                    if (print_properties_.hasINCLUDETPLSTATUS())
-                    {
-                        std::string status = add_tpl_status("OK", m, t);
-                        m->setStringValue(this, status, dve);
-                        return true;
-                    }
-                    return false;
-                }
+                dve = findEntryWithNr(matcher_.measurement_type,
+                                      matcher_.vif_range,
+                                      matcher_.storage_nr_from.intValue(),
+                                      matcher_.tariff_nr_from.intValue(),
+                                      matcher_.index_nr.intValue(),
+                                      &t->dv_entries);
             }
         }
-        // No entry with this key was found.
-        if (t->dv_entries.count(key) == 0)
+        else
+        {
+            dve = t->dv_entries.find(matcher_.dif_vif_key);
+        }
+        // No entry was found.
+        if (dve == NULL)
         {
             // Nothing found, however check if capturing JOIN_TPL_STATUS.
             if (print_properties_.hasINCLUDETPLSTATUS())
@@ -2189,10 +2230,9 @@ bool FieldInfo::extractString(Meter *m, Telegram *t, DVEntry *dve)
             }
             return false;
         }
-        dve = &t->dv_entries[key].second;
     }
     assert(dve != NULL);
-    assert(key == "" || dve->dif_vif_key.str() == key);
+    assert(!matcher_.match_dif_vif_key || dve->dif_vif_key == matcher_.dif_vif_key);
 
     // Generate the json field name:
     std::string field_name = generateFieldNameNoUnit(m, dve);
@@ -2226,7 +2266,7 @@ bool FieldInfo::extractString(Meter *m, Telegram *t, DVEntry *dve)
         dve->extractDate(&datetime);
         std::string extracted_device_date_time;
 
-        if (dve->value.size() == 12)
+        if (dve->valueSize() == 6)
         {
             // A long date time sec + timezone field. TODO add timezone data.
             extracted_device_date_time = strdatetimesec(&datetime);
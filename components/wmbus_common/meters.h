@@ -313,6 +313,10 @@ struct FieldInfo
     bool extractString(Meter *m, Telegram *t, DVEntry *dve = NULL);
     bool hasMatcher();
     bool hasFormula();
+    // The formula of a calculated field, or NULL.
+    Formula *formula() { return formula_.get(); }
+    // The parsed field name template, or NULL.
+    StringInterpolator *fieldName() { return field_name_.get(); }
     bool matches(DVEntry *dve);
     void performExtraction(Meter *m, Telegram *t, DVEntry *dve);
 
@@ -372,6 +376,8 @@ private:
     bool from_library_ {};
 };
 
+struct NumericField;
+
 struct Meter
 {
     // Meters are instantiated on the fly from a template, when a telegram arrives
@@ -407,12 +413,18 @@ struct Meter
     virtual void setNumericValue(FieldInfo *fi, DVEntry *dve, Unit u, double v) = 0;
     virtual double getNumericValue(std::string vname, Unit u) = 0;
     virtual double getNumericValue(FieldInfo *fi, Unit u) = 0;
+    // Return the storage of the numeric value of the field, or NULL if no value has been set yet.
+    // The storage is never moved or removed, so the pointer can be kept for the lifetime of the meter.
+    virtual NumericField *numericFieldStorage(FieldInfo *fi) = 0;
     virtual void setStringValue(FieldInfo *fi, std::string v, DVEntry *dve) = 0;
     virtual void setStringValue(std::string vname, std::string v, DVEntry *dve = NULL) = 0;
     virtual std::string getStringValue(FieldInfo *fi) = 0;
     virtual std::string decodeTPLStatusByte(uchar sts) = 0;
 
     virtual int numUpdates() = 0;
+    // How often the field extraction plan remembered for a telegram layout was reused or had to be (re)built.
+    virtual int numExtractionPlanHits() = 0;
+    virtual int numExtractionPlanMisses() = 0;
 
     virtual void createMeterEnv(std::string id,
                                 std::vector<std::string> *envs,
@@ -429,7 +441,7 @@ struct Meter
     // The handleTelegram expects an input_frame where the DLL crcs have been removed.
     // Returns true of this meter handled this telegram!
     // Sets id_match to true, if there was an id match, even though the telegram could not be properly handled.
-    virtual bool handleTelegram(AboutTelegram &about, std::vector<uchar> input_frame,
+    virtual bool handleTelegram(AboutTelegram &about, const std::vector<uchar> &input_frame,
                                 bool simulated, std::vector<Address> *addresses,
                                 bool *id_match, Telegram *out_t = NULL) = 0;
     virtual MeterKeys *meterKeys() = 0;
@@ -81,6 +81,8 @@ struct MeterCommonImplementation : public virtual Meter
 
     void onUpdate(function<void(Telegram*,Meter*)> cb);
     int numUpdates();
+    int numExtractionPlanHits();
+    int numExtractionPlanMisses();
 
     static bool isTelegramForMeter(Telegram *t, Meter *meter, MeterInfo *mi);
     MeterKeys *meterKeys();
@@ -160,7 +162,7 @@ protected:
         std::string help,
         PrintProperties print_properties);
 
-    bool handleTelegram(AboutTelegram &about, std::vector<uchar> frame,
+    bool handleTelegram(AboutTelegram &about, const std::vector<uchar> &frame,
                         bool simulated, std::vector<Address> *addresses,
                         bool *id_match, Telegram *out_analyzed = NULL);
     void createMeterEnv(std::string id,
@@ -192,6 +194,7 @@ protected:
     void setNumericValue(FieldInfo *fi, DVEntry *dve, Unit u, double v);
     double getNumericValue(std::string vname, Unit u);
     double getNumericValue(FieldInfo *fi, Unit u);
+    NumericField *numericFieldStorage(FieldInfo *fi);
     void setStringValue(std::string vname, std::string v, DVEntry *dve = NULL);
     void setStringValue(FieldInfo *fi, std::string v, DVEntry *dve);
     std::string getStringValue(FieldInfo *fi);
@@ -226,6 +229,8 @@ private:
     std::vector<AddressExpression> address_expressions_;
     IdentityMode identity_mode_;
     int num_updates_ {};
+    int num_extraction_plan_hits_ {};
+    int num_extraction_plan_misses_ {};
     time_t datetime_of_update_ {};
     time_t datetime_of_poll_ {};
     LinkModeSet link_modes_ {};
@@ -238,6 +243,24 @@ private:
     bool has_process_content_ = false;
     bool has_received_first_telegram_ = false;
 
+    // The result of matching the field infos against the dv entries of a telegram layout.
+    // Later telegrams with the same layout replay the steps instead of matching again.
+    struct ExtractionPlan
+    {
+        uint64_t layout_hash {};
+        size_t num_entries {};
+        size_t num_fields {};
+        std::vector<std::pair<uint16_t,uint16_t>> steps; // Field info index and dv entry index, in extraction order.
+        std::vector<bool> matched; // Field infos that were matched against at least one dv entry.
+    };
+    // Meters often alternate between a few layouts (e.g. full and compact frames), so keep more than one.
+    static const size_t MAX_EXTRACTION_PLANS = 4;
+    std::vector<ExtractionPlan> extraction_plans_;
+    size_t next_extraction_plan_ {};
+
+    ExtractionPlan *findExtractionPlan(Telegram *t, uint64_t layout_hash);
+    void buildExtractionPlan(Telegram *t, ExtractionPlan *plan);
+
 protected:
 
     std::vector<FieldInfo> field_infos_;
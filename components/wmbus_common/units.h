@@ -313,6 +313,9 @@ double multiply(double l, Unit left, double r, Unit right);
 // not a valid conversion, but permitted to work around limitations in the mbus protocol usage.
 bool overrideConversion(Unit from, Unit to);
 
+// True for the temperature units K, C and F, which convert into each other with an offset.
+bool isKCF(const SIExp &e);
+
 // Either uppercase KWH or lowercase kwh works here.
 Unit toUnit(std::string s);
 Quantity toQuantity(std::string s);
@@ -166,6 +166,17 @@ std::string bin2hex(const std::vector<uchar> &target) {
     return str;
 }
 
+std::string bin2hex(const uchar *data, size_t len) {
+    std::string str;
+    str.reserve(len*2);
+    for (size_t i = 0; i < len; ++i) {
+        const char ch = data[i];
+        str.append(&hexChar[(ch  & 0xF0) >> 4], 1);
+        str.append(&hexChar[ch & 0xF], 1);
+    }
+    return str;
+}
+
 std::string bin2hex (std::vector<uchar>::iterator data, std::vector<uchar>::iterator end, int len) {
     std::string str;
     while (data != end && len-- > 0) {
@@ -246,7 +257,7 @@ void strprintf(std::string *s, const char* fmt, ...)
     *s = buf;
 }
 
-void xorit(uchar *srca, uchar *srcb, uchar *dest, int len)
+void xorit(const uchar *srca, const uchar *srcb, uchar *dest, int len)
 {
     for (int i=0; i<len; ++i) { dest[i] = srca[i]^srcb[i]; }
 }
@@ -368,18 +379,6 @@ void incrementIV(uchar *iv, size_t len) {
     }
 }
 
-void debugPayload(const std::string& intro, std::vector<uchar> &payload)
-{
-    std::string msg = bin2hex(payload);
-    debug("%s \"%s\"\n", intro.c_str(), msg.c_str());
-}
-
-void debugPayload(const std::string& intro, std::vector<uchar> &payload, std::vector<uchar>::iterator &pos)
-{
-    std::string msg = bin2hex(pos, payload.end(), 1024);
-    debug("%s \"%s\"\n", intro.c_str(), msg.c_str());
-}
-
 void logTelegram (std::vector<uchar> &original, std::vector<uchar> &parsed, int header_size, int suffix_size)
 {
     std::vector<uchar> logged = parsed;
@@ -480,25 +479,33 @@ int parseTime(const std::string& s)
 
 #define CRC16_EN_13757 0x3D65
 
-uint16_t crc16_EN13757_per_byte(uint16_t crc, uchar b)
+struct Crc16EN13757Table
 {
-    unsigned char i;
+    uint16_t entries[256];
 
-    for (i = 0; i < 8; i++) {
-
-        if (((crc & 0x8000) >> 8) ^ (b & 0x80)){
-            crc = (crc << 1)  ^ CRC16_EN_13757;
-        }else{
-            crc = (crc << 1);
+    constexpr Crc16EN13757Table() : entries()
+    {
+        for (int b = 0; b < 256; ++b)
+        {
+            uint16_t crc = b << 8;
+            for (int i = 0; i < 8; ++i)
+            {
+                crc = (crc & 0x8000) ? (crc << 1) ^ CRC16_EN_13757 : (crc << 1);
+            }
+            entries[b] = crc;
         }
-
-        b <<= 1;
     }
+};
 
-    return crc;
+// One lookup per byte instead of 8 shift/xor steps, table is generated at compile time.
+static constexpr Crc16EN13757Table crc16_EN13757_table;
+
+uint16_t crc16_EN13757_per_byte(uint16_t crc, uchar b)
+{
+    return (crc << 8) ^ crc16_EN13757_table.entries[((crc >> 8) ^ b) & 0xff];
 }
 
-uint16_t crc16_EN13757(uchar *data, size_t len)
+uint16_t crc16_EN13757(const uchar *data, size_t len)
 {
     uint16_t crc = 0x0000;
 
@@ -512,6 +519,13 @@ uint16_t crc16_EN13757(uchar *data, size_t len)
     return (~crc);
 }
 
+bool crc16_EN13757_check(const uchar *data, size_t len)
+{
+    uint16_t calc_crc = crc16_EN13757(data, len);
+    uint16_t check_crc = data[len] << 8 | data[len+1];
+    return calc_crc == check_crc;
+}
+
 #define CRC16_INIT_VALUE 0xFFFF
 #define CRC16_GOOD_VALUE 0x0F47
 #define CRC16_POLYNOM    0x8408
@@ -681,6 +695,9 @@ int get_days_in_month(int year, int month)
 
 double addMonths(double t, int months)
 {
+    // A missing timestamp cannot be converted into a time_t, keep it missing.
+    if (::isnan(t)) return t;
+
     time_t ut = (time_t)t;
     struct tm time;
     localtime_r(&ut, &time);
@@ -1343,12 +1360,17 @@ bool isLikelyAscii(const std::string& v)
     std::vector<uchar> val;
     bool ok = hex2bin(v, &val);
 
+    if (!ok) return false;
+
+    return isLikelyAscii(val);
+}
+
+bool isLikelyAscii(const std::vector<uchar>& val)
+{
     // For example 64 bits:
     // 0000 0000 4142 4344
     // is probably the std::string DCBA
 
-    if (!ok) return false;
-
     size_t i = 0;
     for (; i < val.size(); ++i)
     {
@@ -49,6 +49,7 @@ std::string reverseBCD(const std::string &v);
 std::string reverseBinaryAsciiSafeToString(const std::string &v);
 // Check if hex std::string is likely to be ascii
 bool isLikelyAscii(const std::string &v);
+bool isLikelyAscii(const std::vector<uchar> &v);
 
 bool isHexChar(uchar c);
 
@@ -63,6 +64,7 @@ bool hex2bin(const char *src, std::vector<uchar> *target);
 bool hex2bin(const std::string &src, std::vector<uchar> *target);
 bool hex2bin(std::vector<uchar> &src, std::vector<uchar> *target);
 std::string bin2hex(const std::vector<uchar> &target);
+std::string bin2hex(const uchar *data, size_t len);
 std::string bin2hex(std::vector<uchar>::iterator data, std::vector<uchar>::iterator end, int len);
 std::string bin2hex(std::vector<uchar> &data, int offset, int len);
 std::string safeString(std::vector<uchar> &target);
@@ -87,7 +89,7 @@ double addMonths(double t, int m);
 
 bool stringFoundCaseIgnored(const std::string &haystack, const std::string &needle);
 
-void xorit(uchar *srca, uchar *srcb, uchar *dest, int len);
+void xorit(const uchar *srca, const uchar *srcb, uchar *dest, int len);
 void shiftLeft(uchar *srca, uchar *srcb, int len);
 std::string format3fdot3f(double v);
 
@@ -98,8 +100,8 @@ std::string format3fdot3f(double v);
 #define warning(...) //esph_log_w("wmbusmeters", __VA_ARGS__)
 #define error(...) //esph_log_e("wmbusmeters", __VA_ARGS__)
 
-void debugPayload(const std::string &intro, std::vector<uchar> &payload);
-void debugPayload(const std::string &intro, std::vector<uchar> &payload, std::vector<uchar>::iterator &pos);
+// Compiled out with debug(), so hex dumps (and their heap allocations) are not made for nothing on every telegram
+#define debugPayload(...)
 void logTelegram(std::vector<uchar> &original, std::vector<uchar> &parsed, int header_size, int suffix_size);
 
 enum class Alarm
@@ -142,7 +144,9 @@ int parseTime(const std::string &time);
 bool isInsideTimePeriod(time_t now, std::string periods);
 bool isValidTimePeriod(const std::string &periods);
 
-uint16_t crc16_EN13757(uchar *data, size_t len);
+uint16_t crc16_EN13757(const uchar *data, size_t len);
+// Check len bytes of data against the big endian crc stored right after them.
+bool crc16_EN13757_check(const uchar *data, size_t len);
 
 // This crc is used by im871a for its serial communication.
 uint16_t crc16_CCITT(uchar *data, uint16_t length);
@@ -1026,7 +1026,7 @@ bool Telegram::parseELL (std::vector<uchar>::iterator &pos)
         {
             if (meter_keys)
             {
-                decrypt_ELL_AES_CTR(this, frame, pos, meter_keys->confidentiality_key);
+                decrypt_ELL_AES_CTR(this, frame, pos, meter_keys->confidentialityAESKey());
                 // Actually this ctr decryption always succeeds, if wrong key, it will decrypt to garbage.
             }
             // Now the frame from pos and onwards has been decrypted, perhaps.
@@ -1344,7 +1344,7 @@ bool Telegram::parseTPLConfig(std::vector<uchar>::iterator &pos)
                 debug("(wmbus) no key, thus cannot execute kdf.\n");
                 return false;
             }
-            AES_CMAC(safeButUnsafeVectorPtr(meter_keys->confidentiality_key),
+            AES_CMAC(meter_keys->confidentialityAESKey(),
                      safeButUnsafeVectorPtr(input), 16,
                      safeButUnsafeVectorPtr(mac));
             std::string s = bin2hex(mac);
@@ -1356,7 +1356,7 @@ bool Telegram::parseTPLConfig(std::vector<uchar>::iterator &pos)
             mac.clear();
             mac.resize(16);
             debugPayload("(wmbus) input to kdf for mac", input);
-            AES_CMAC(safeButUnsafeVectorPtr(meter_keys->confidentiality_key),
+            AES_CMAC(meter_keys->confidentialityAESKey(),
                      safeButUnsafeVectorPtr(input), 16,
                      safeButUnsafeVectorPtr(mac));
             s = bin2hex(mac);
@@ -1454,7 +1454,7 @@ bool Telegram::checkMAC(std::vector<uchar> &frame,
     input.insert(input.end(), from, to);
     std::string s = bin2hex(input);
     debug("(wmbus) input to mac %s\n", s.c_str());
-    AES_CMAC(safeButUnsafeVectorPtr(mackey),
+    AES_CMAC(AESKey(mackey),
              safeButUnsafeVectorPtr(input), input.size(),
              safeButUnsafeVectorPtr(mac));
     std::string calculated = bin2hex(mac);
@@ -1516,7 +1516,7 @@ bool Telegram::potentiallyDecrypt (std::vector<uchar>::iterator &pos)
         int num_encrypted_bytes = 0;
         int num_not_encrypted_at_end = 0;
 
-        bool ok = decrypt_TPL_AES_CBC_IV(this, frame, pos, meter_keys->confidentiality_key,
+        bool ok = decrypt_TPL_AES_CBC_IV(this, frame, pos, meter_keys->confidentialityAESKey(),
                                          &num_encrypted_bytes, &num_not_encrypted_at_end);
         if (!ok)
         {
@@ -1635,7 +1635,7 @@ bool Telegram::potentiallyDecrypt (std::vector<uchar>::iterator &pos)
 
         int num_encrypted_bytes = 0;
         int num_not_encrypted_at_end = 0;
-        bool ok = decrypt_TPL_AES_CBC_NO_IV(this, frame, pos, tpl_generated_key,
+        bool ok = decrypt_TPL_AES_CBC_NO_IV(this, frame, pos, AESKey(tpl_generated_key),
                                             &num_encrypted_bytes,
                                             &num_not_encrypted_at_end);
         if (!ok)
@@ -1884,7 +1884,16 @@ void Telegram::preProcess()
     }
 }
 
-bool Telegram::parse (std::vector<uchar> &input_frame, MeterKeys *mk, bool warn)
+const AESKey &MeterKeys::confidentialityAESKey()
+{
+    if (!confidentiality_aes_key_.sameAs(confidentiality_key))
+    {
+        confidentiality_aes_key_.set(confidentiality_key);
+    }
+    return confidentiality_aes_key_;
+}
+
+bool Telegram::parse (const std::vector<uchar> &input_frame, MeterKeys *mk, bool warn)
 {
     switch (about.type)
     {
@@ -1896,7 +1905,7 @@ bool Telegram::parse (std::vector<uchar> &input_frame, MeterKeys *mk, bool warn)
     return false;
 }
 
-bool Telegram::parseHeader (std::vector<uchar> &input_frame)
+bool Telegram::parseHeader (const std::vector<uchar> &input_frame)
 {
     switch (about.type)
     {
@@ -1908,7 +1917,7 @@ bool Telegram::parseHeader (std::vector<uchar> &input_frame)
     return false;
 }
 
-bool Telegram::parseWMBUSHeader (std::vector<uchar> &input_frame)
+bool Telegram::parseWMBUSHeader (const std::vector<uchar> &input_frame)
 {
     assert(about.type == FrameType::WMBUS);
 
@@ -1948,7 +1957,7 @@ bool Telegram::parseWMBUSHeader (std::vector<uchar> &input_frame)
     return true;
 }
 
-bool Telegram::parseWMBUS (std::vector<uchar> &input_frame, MeterKeys *mk, bool warn)
+bool Telegram::parseWMBUS (const std::vector<uchar> &input_frame, MeterKeys *mk, bool warn)
 {
     assert(about.type == FrameType::WMBUS);
 
@@ -2025,7 +2034,7 @@ bool Telegram::parseWMBUS (std::vector<uchar> &input_frame, MeterKeys *mk, bool
     return true;
 }
 
-bool Telegram::parseMBUSHeader (std::vector<uchar> &input_frame)
+bool Telegram::parseMBUSHeader (const std::vector<uchar> &input_frame)
 {
     assert(about.type == FrameType::MBUS);
 
@@ -2048,7 +2057,7 @@ bool Telegram::parseMBUSHeader (std::vector<uchar> &input_frame)
     return true;
 }
 
-bool Telegram::parseMBUS (std::vector<uchar> &input_frame, MeterKeys *mk, bool warn)
+bool Telegram::parseMBUS (const std::vector<uchar> &input_frame, MeterKeys *mk, bool warn)
 {
     assert(about.type == FrameType::MBUS);
 
@@ -2076,14 +2085,14 @@ bool Telegram::parseMBUS (std::vector<uchar> &input_frame, MeterKeys *mk, bool w
     return true;
 }
 
-bool Telegram::parseHANHeader (std::vector<uchar> &input_frame)
+bool Telegram::parseHANHeader (const std::vector<uchar> &input_frame)
 {
     assert(about.type == FrameType::HAN);
 
     return false;
 }
 
-bool Telegram::parseHAN (std::vector<uchar> &input_frame, MeterKeys *mk, bool warn)
+bool Telegram::parseHAN (const std::vector<uchar> &input_frame, MeterKeys *mk, bool warn)
 {
     assert(about.type == FrameType::HAN);
 
@@ -4171,8 +4180,8 @@ bool trimCRCsFrameFormatAInternal(std::vector<uchar> &payload, bool fail_is_ok)
         debugPayload("(wmbus) trimming frame A", payload);
     }
 
-    std::vector<uchar> out;
-
+    // All crcs are checked before any byte is moved, so the payload is left untouched on failure
+    // and can still be tried as format B.
     uint16_t calc_crc = crc16_EN13757(safeButUnsafeVectorPtr(payload), 10);
     uint16_t check_crc = payload[10] << 8 | payload[11];
 
@@ -4184,7 +4193,6 @@ bool trimCRCsFrameFormatAInternal(std::vector<uchar> &payload, bool fail_is_ok)
         }
         return false;
     }
-    out.insert(out.end(), payload.begin(), payload.begin()+10);
     if (!fail_is_ok)
     {
         debug("(wmbus) ff a dll crc 0-%zu %04x ok\n", 10-1, calc_crc);
@@ -4205,7 +4213,6 @@ bool trimCRCsFrameFormatAInternal(std::vector<uchar> &payload, bool fail_is_ok)
             }
             return false;
         }
-        out.insert(out.end(), payload.begin()+pos, payload.begin()+pos+16);
         if (!fail_is_ok)
         {
             debug("(wmbus) ff a dll crc mid %zu-%zu %04x ok\n", pos, to-1, calc_crc);
@@ -4227,7 +4234,6 @@ bool trimCRCsFrameFormatAInternal(std::vector<uchar> &payload, bool fail_is_ok)
             }
             return false;
         }
-        out.insert(out.end(), payload.begin()+pos, payload.begin()+tto);
         if (!fail_is_ok)
         {
             debug("(wmbus) ff a dll crc final %zu-%zu %04x ok\n", pos, tto-1, calc_crc);
@@ -4236,10 +4242,23 @@ bool trimCRCsFrameFormatAInternal(std::vector<uchar> &payload, bool fail_is_ok)
 
     debugPayload("(wmbus) trimming frame A", payload);
 
-    out[0] = out.size()-1;
-    size_t new_len = out[0]+1;
+    // Compact the blocks in place, the first 10 bytes are already where they belong.
+    size_t out_len = 10;
+    for (pos = 12; pos+18 <= len; pos += 18)
+    {
+        memmove(&payload[out_len], &payload[pos], 16);
+        out_len += 16;
+    }
+    if (pos < len-2)
+    {
+        memmove(&payload[out_len], &payload[pos], len-2-pos);
+        out_len += len-2-pos;
+    }
+
+    payload[0] = out_len-1;
+    size_t new_len = payload[0]+1;
     size_t old_size = payload.size();
-    payload = out;
+    payload.resize(out_len);
     size_t new_size = payload.size();
 
     debug("(wmbus) trimmed %zu dll crc bytes from frame a and ignored %zu suffix bytes.\n", (len-new_len), (old_size-new_size)-(len-new_len));
@@ -4263,7 +4282,7 @@ bool trimCRCsFrameFormatBInternal(std::vector<uchar> &payload, bool fail_is_ok)
         debugPayload("(wmbus) trimming frame B", payload);
     }
 
-    std::vector<uchar> out;
+    // All crcs are checked before any byte is moved, so the payload is left untouched on failure.
     size_t crc1_pos, crc2_pos;
     if (len <= 128)
     {
@@ -4290,7 +4309,6 @@ bool trimCRCsFrameFormatBInternal(std::vector<uchar> &payload, bool fail_is_ok)
         return false;
     }
 
-    out.insert(out.end(), payload.begin(), payload.begin()+crc1_pos);
     if (!fail_is_ok)
     {
         debug("(wmbus) ff b dll crc first 0-%zu %04x ok\n", crc1_pos, calc_crc);
@@ -4313,7 +4331,6 @@ bool trimCRCsFrameFormatBInternal(std::vector<uchar> &payload, bool fail_is_ok)
             return false;
         }
 
-        out.insert(out.end(), payload.begin()+crc1_pos+2, payload.begin()+crc2_pos);
         if (!fail_is_ok)
         {
             debug("(wmbus) ff b dll crc final %zu-%zu %04x ok\n", crc1_pos+2, crc2_pos, calc_crc);
@@ -4322,10 +4339,18 @@ bool trimCRCsFrameFormatBInternal(std::vector<uchar> &payload, bool fail_is_ok)
 
     debugPayload("(wmbus) trimming frame B", payload);
 
-    out[0] = out.size()-1;
-    size_t new_len = out[0]+1;
+    // Only the second block has to be moved over the first crc.
+    size_t out_len = crc1_pos;
+    if (crc2_pos > 0)
+    {
+        memmove(&payload[out_len], &payload[crc1_pos+2], crc2_pos-crc1_pos-2);
+        out_len += crc2_pos-crc1_pos-2;
+    }
+
+    payload[0] = out_len-1;
+    size_t new_len = payload[0]+1;
     size_t old_size = payload.size();
-    payload = out;
+    payload.resize(out_len);
     size_t new_size = payload.size();
 
     debug("(wmbus) trimmed %zu dll crc bytes from frame b and ignored %zu suffix bytes.\n", (len-new_len), (old_size-new_size)-(len-new_len));
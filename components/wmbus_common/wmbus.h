@@ -19,6 +19,7 @@
 #define WMBUS_H
 
 #include"address.h"
+#include"aes_backend.h"
 #include"dvparser.h"
 #include"manufacturers.h"
 #include"translatebits.h"
@@ -285,6 +286,14 @@ struct MeterKeys
 
     bool hasConfidentialityKey() { return confidentiality_key.size() > 0; }
     bool hasAuthenticationKey() { return authentication_key.size() > 0; }
+
+    // The confidentiality key with its key schedule expanded, for use in the decryption of every telegram.
+    // It is expanded again only if confidentiality_key has been changed since the last call.
+    const AESKey &confidentialityAESKey();
+
+private:
+
+    AESKey confidentiality_aes_key_;
 };
 
 enum class FrameType
@@ -470,17 +479,17 @@ public:
 
     bool handled {}; // Set to true, when a meter has accepted the telegram.
 
-    bool parseHeader (std::vector<uchar> &input_frame);
-    bool parse (std::vector<uchar> &input_frame, MeterKeys *mk, bool warn);
+    bool parseHeader (const std::vector<uchar> &input_frame);
+    bool parse (const std::vector<uchar> &input_frame, MeterKeys *mk, bool warn);
 
-    bool parseMBUSHeader (std::vector<uchar> &input_frame);
-    bool parseMBUS (std::vector<uchar> &input_frame, MeterKeys *mk, bool warn);
+    bool parseMBUSHeader (const std::vector<uchar> &input_frame);
+    bool parseMBUS (const std::vector<uchar> &input_frame, MeterKeys *mk, bool warn);
 
-    bool parseWMBUSHeader (std::vector<uchar> &input_frame);
-    bool parseWMBUS (std::vector<uchar> &input_frame, MeterKeys *mk, bool warn);
+    bool parseWMBUSHeader (const std::vector<uchar> &input_frame);
+    bool parseWMBUS (const std::vector<uchar> &input_frame, MeterKeys *mk, bool warn);
 
-    bool parseHANHeader (std::vector<uchar> &input_frame);
-    bool parseHAN (std::vector<uchar> &input_frame, MeterKeys *mk, bool warn);
+    bool parseHANHeader (const std::vector<uchar> &input_frame);
+    bool parseHAN (const std::vector<uchar> &input_frame, MeterKeys *mk, bool warn);
 
     void addAddressMfctFirst(const std::vector<uchar>::iterator &pos);
     void addAddressIdFirst(const std::vector<uchar>::iterator &pos);
@@ -507,8 +516,8 @@ public:
     void markAsBeingAnalyzed() { being_analyzed_ = true; }
 
     // The actual content of the (w)mbus telegram. The DifVif entries.
-    // Mapped from their key for quick access to their offset and content.
-    std::map<std::string,std::pair<int,DVEntry>> dv_entries;
+    // Kept in telegram order and indexed by their difvif key for quick access.
+    DVEntries dv_entries;
 
     std::string autoDetectPossibleDrivers();
 
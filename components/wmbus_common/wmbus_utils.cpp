@@ -16,20 +16,22 @@
 */
 
 
-#include"aes.h"
+#include"aes_backend.h"
 #include"util.h"
 #include"wmbus.h"
+#include"wmbus_utils.h"
 
 #include<assert.h>
 #include<memory.h>
 
-bool decrypt_ELL_AES_CTR(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, std::vector<uchar> &aeskey)
+bool decrypt_ELL_AES_CTR(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, const AESKey &aeskey)
 {
-    if (aeskey.size() == 0) return true;
+    if (!aeskey.isSet()) return true;
 
     std::vector<uchar> encrypted_bytes;
     std::vector<uchar> decrypted_bytes;
     encrypted_bytes.insert(encrypted_bytes.end(), pos, frame.end());
+    decrypted_bytes.reserve(encrypted_bytes.size());
     debugPayload("(ELL) decrypting", encrypted_bytes);
 
     uchar iv[16];
@@ -67,20 +69,15 @@ bool decrypt_ELL_AES_CTR(Telegram *t, std::vector<uchar> &frame, std::vector<uch
 
         // Generate the pseudo-random bits from the IV and the key.
         uchar xordata[16];
-        AES_ECB_encrypt(iv, safeButUnsafeVectorPtr(aeskey), xordata, 16);
+        aeskey.encryptBlock(iv, xordata);
 
-        // Xor the data with the pseudo-random bits to decrypt into tmp.
-        uchar tmp[block_size];
-        xorit(xordata, &encrypted_bytes[offset], tmp, block_size);
+        // Xor the data with the pseudo-random bits to decrypt straight into decrypted_bytes.
+        decrypted_bytes.resize(offset + block_size);
+        xorit(xordata, &encrypted_bytes[offset], &decrypted_bytes[offset], block_size);
 
         debug("(ELL) block %d block_size %d offset %zu\n", block, block_size, offset);
         block++;
 
-        std::vector<uchar> tmpv(tmp, tmp+block_size);
-        debugPayload("(ELL) decrypted", tmpv);
-
-        decrypted_bytes.insert(decrypted_bytes.end(), tmpv.begin(), tmpv.end());
-
         incrementIV(iv, sizeof(iv));
     }
     debugPayload("(ELL) decrypted", decrypted_bytes);
@@ -93,6 +90,11 @@ bool decrypt_ELL_AES_CTR(Telegram *t, std::vector<uchar> &frame, std::vector<uch
     return true;
 }
 
+bool decrypt_ELL_AES_CTR(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, std::vector<uchar> &aeskey)
+{
+    return decrypt_ELL_AES_CTR(t, frame, pos, AESKey(aeskey));
+}
+
 std::string frameTypeKamstrupC1(int ft) {
     if (ft == 0x78) return "long frame";
     if (ft == 0x79) return "short frame";
@@ -102,7 +104,7 @@ std::string frameTypeKamstrupC1(int ft) {
 bool decrypt_TPL_AES_CBC_IV(Telegram *t,
                             std::vector<uchar> &frame,
                             std::vector<uchar>::iterator &pos,
-                            std::vector<uchar> &aeskey,
+                            const AESKey &aeskey,
                             int *num_encrypted_bytes,
                             int *num_not_encrypted_at_end)
 {
@@ -136,7 +138,7 @@ bool decrypt_TPL_AES_CBC_IV(Telegram *t,
     debug("(TPL) num encrypted blocks %zu (%d bytes and remaining unencrypted %zu bytes)\n",
           t->tpl_num_encr_blocks, num_bytes_to_decrypt, buffer.size()-num_bytes_to_decrypt);
 
-    if (aeskey.size() == 0) return false;
+    if (!aeskey.isSet()) return false;
 
     debugPayload("(TPL) AES CBC IV decrypting", buffer);
 
@@ -184,7 +186,7 @@ bool decrypt_TPL_AES_CBC_IV(Telegram *t,
     memcpy(buffer_data, safeButUnsafeVectorPtr(buffer), num_bytes_to_decrypt);
     uchar decrypted_data[num_bytes_to_decrypt];
 
-    AES_CBC_decrypt_buffer(decrypted_data, buffer_data, num_bytes_to_decrypt, safeButUnsafeVectorPtr(aeskey), iv);
+    aeskey.decryptCBC(buffer_data, decrypted_data, num_bytes_to_decrypt, iv);
 
     // Remove the encrypted bytes.
     frame.erase(pos, frame.end());
@@ -202,11 +204,21 @@ bool decrypt_TPL_AES_CBC_IV(Telegram *t,
     return true;
 }
 
-bool decrypt_TPL_AES_CBC_NO_IV(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, std::vector<uchar> &aeskey,
+bool decrypt_TPL_AES_CBC_IV(Telegram *t,
+                            std::vector<uchar> &frame,
+                            std::vector<uchar>::iterator &pos,
+                            std::vector<uchar> &aeskey,
+                            int *num_encrypted_bytes,
+                            int *num_not_encrypted_at_end)
+{
+    return decrypt_TPL_AES_CBC_IV(t, frame, pos, AESKey(aeskey), num_encrypted_bytes, num_not_encrypted_at_end);
+}
+
+bool decrypt_TPL_AES_CBC_NO_IV(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, const AESKey &aeskey,
                                int *num_encrypted_bytes,
                                int *num_not_encrypted_at_end)
 {
-    if (aeskey.size() == 0) return true;
+    if (!aeskey.isSet()) return true;
 
     std::vector<uchar> buffer;
     buffer.insert(buffer.end(), pos, frame.end());
@@ -233,7 +245,7 @@ bool decrypt_TPL_AES_CBC_NO_IV(Telegram *t, std::vector<uchar> &frame, std::vect
     debug("(TPL) num encrypted blocks %d (%d bytes and remaining unencrypted %d bytes)\n",
           t->tpl_num_encr_blocks, num_bytes_to_decrypt, buffer.size()-num_bytes_to_decrypt);
 
-    if (aeskey.size() == 0) return false;
+    if (!aeskey.isSet()) return false;
 
     // The content should be a multiple of 16 since we are using AES CBC mode.
     if (num_bytes_to_decrypt % 16 != 0)
@@ -256,7 +268,7 @@ bool decrypt_TPL_AES_CBC_NO_IV(Telegram *t, std::vector<uchar> &frame, std::vect
     memcpy(buffer_data, safeButUnsafeVectorPtr(buffer), num_bytes_to_decrypt);
     uchar decrypted_data[num_bytes_to_decrypt];
 
-    AES_CBC_decrypt_buffer(decrypted_data, buffer_data, num_bytes_to_decrypt, safeButUnsafeVectorPtr(aeskey), iv);
+    aeskey.decryptCBC(buffer_data, decrypted_data, num_bytes_to_decrypt, iv);
 
     // Remove the encrypted bytes and any potentially not decryptes bytes after.
     frame.erase(pos, frame.end());
@@ -274,3 +286,10 @@ bool decrypt_TPL_AES_CBC_NO_IV(Telegram *t, std::vector<uchar> &frame, std::vect
 
     return true;
 }
+
+bool decrypt_TPL_AES_CBC_NO_IV(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, std::vector<uchar> &aeskey,
+                               int *num_encrypted_bytes,
+                               int *num_not_encrypted_at_end)
+{
+    return decrypt_TPL_AES_CBC_NO_IV(t, frame, pos, AESKey(aeskey), num_encrypted_bytes, num_not_encrypted_at_end);
+}
@@ -21,10 +21,19 @@
 #include "util.h"
 #include "wmbus.h"
 
+// Pass an AESKey (e.g. from MeterKeys::confidentialityAESKey) to reuse its key schedule,
+// the std::vector versions expand the key on every call.
+bool decrypt_ELL_AES_CTR(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, const AESKey &aeskey);
 bool decrypt_ELL_AES_CTR(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, std::vector<uchar> &aeskey);
+bool decrypt_TPL_AES_CBC_IV(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, const AESKey &aeskey,
+                            int *num_encrypted_bytes,
+                            int *num_not_encrypted_at_end);
 bool decrypt_TPL_AES_CBC_IV(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, std::vector<uchar> &aeskey,
                             int *num_encrypted_bytes,
                             int *num_not_encrypted_at_end);
+bool decrypt_TPL_AES_CBC_NO_IV(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, const AESKey &aeskey,
+                               int *num_encrypted_bytes,
+                               int *num_not_encrypted_at_end);
 bool decrypt_TPL_AES_CBC_NO_IV(Telegram *t, std::vector<uchar> &frame, std::vector<uchar>::iterator &pos, std::vector<uchar> &aeskey,
                                int *num_encrypted_bytes,
                                int *num_not_encrypted_at_end);
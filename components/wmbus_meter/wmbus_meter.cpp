@@ -30,7 +30,8 @@ bool Meter::is_encrypted() const { return this->meter && this->meter->meterKeys(
 
 void Meter::set_radio(wmbus_radio::Radio *radio) {
   this->radio = radio;
-  radio->add_frame_handler([this](wmbus_radio::Frame *frame) { return this->handle_frame(frame); });
+  radio->add_frame_handler(std::strtoul(this->get_id().c_str(), nullptr, 16),
+                           [this](wmbus_radio::Frame *frame) { return this->handle_frame(frame); });
 }
 
 void Meter::dump_config() {
@@ -41,17 +42,27 @@ void Meter::dump_config() {
 }
 
 void Meter::handle_frame(wmbus_radio::Frame *frame) {
-  auto about = AboutTelegram(App.get_friendly_name(), frame->rssi(), frame->link_mode(), FrameType::WMBUS);
+  auto about = AboutTelegram(App.get_friendly_name(), frame->rssi(), frame->link_mode(), FrameType::WMBUS,
+                             frame->rx_time().tv_sec);
 
   std::vector<Address> adresses;
   bool id_match = false;
-  auto telegram = std::make_unique<Telegram>();
+  auto telegram = std::make_shared<Telegram>();
 
-  this->meter->handleTelegram(about, frame->data(), false, &adresses, &id_match, telegram.get());
+  {
+    // Frame may be handled in radio processing task while previous telegram is still published
+    LockGuard lock(this->meter_lock_);
+    this->meter->handleTelegram(about, frame->data(), false, &adresses, &id_match, telegram.get());
+  }
 
   if (id_match) {
-    this->last_telegram = std::move(telegram);
-    this->defer([this]() {
+    ESP_LOGV(TAG, "Field extraction plan reused for %d of %d telegrams", this->meter->numExtractionPlanHits(),
+             this->meter->numExtractionPlanHits() + this->meter->numExtractionPlanMisses());
+
+    // Only publishing is done on main loop
+    this->defer([this, telegram]() {
+      LockGuard lock(this->meter_lock_);
+      this->last_telegram = telegram;
       this->on_telegram_callback_manager();
       this->last_telegram = nullptr;
     });
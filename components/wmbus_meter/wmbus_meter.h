@@ -30,7 +30,8 @@ class Meter : public Component {
   wmbus_radio::Radio *radio;
 
   std::shared_ptr<::Meter> meter;
-  std::unique_ptr<Telegram> last_telegram;
+  std::shared_ptr<Telegram> last_telegram;
+  Mutex meter_lock_;
 
   CallbackManager<void()> on_telegram_callback_manager;
 
@@ -3,6 +3,12 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome import pins, automation
 from esphome.components import spi
+from esphome.components.esp32 import get_esp32_variant
+from esphome.components.esp32.const import (
+    VARIANT_ESP32,
+    VARIANT_ESP32P4,
+    VARIANT_ESP32S3,
+)
 from esphome.cpp_generator import LambdaExpression
 from esphome.const import (
     CONF_ID,
@@ -11,6 +17,8 @@ from esphome.const import (
     CONF_TRIGGER_ID,
     CONF_FORMAT,
     CONF_DATA,
+    CONF_PRIORITY,
+    CONF_FREQUENCY,
 )
 from pathlib import Path
 
@@ -28,6 +36,17 @@ CONF_ON_FRAME = "on_frame"
 CONF_RADIO_TYPE = "radio_type"
 CONF_MARK_AS_HANDLED = "mark_as_handled"
 CONF_PACKET_TRIGGER_ID = "packet_trigger_id"
+CONF_QUEUE_SIZE = "queue_size"
+CONF_ADDRESS_FILTER = "address_filter"
+CONF_DUPLICATE_WINDOW = "duplicate_window"
+CONF_PROCESSING_TASK = "processing_task"
+CONF_LOOP_BUDGET = "loop_budget"
+CONF_STACK_SIZE = "stack_size"
+CONF_CORE = "core"
+CONF_RADIO_PROFILE = "radio_profile"
+CONF_BITRATE = "bitrate"
+CONF_DEVIATION = "deviation"
+CONF_BANDWIDTH = "bandwidth"
 
 radio_ns = cg.esphome_ns.namespace("wmbus_radio")
 RadioComponent = radio_ns.class_("Radio", cg.Component)
@@ -37,6 +56,9 @@ FrameOutputFormat = Frame.enum("OutputFormat")
 FramePtr = Frame.operator("ptr")
 FrameTrigger = radio_ns.class_("FrameTrigger", automation.Trigger.template(FramePtr))
 
+SX1276Profile = radio_ns.struct("SX1276Profile")
+LinkMode = cg.global_ns.enum("LinkMode", is_class=True)
+
 Packet = radio_ns.class_("Packet")
 PacketPtr = Packet.operator("ptr")
 PacketTrigger = radio_ns.class_("PacketTrigger", automation.Trigger.template(PacketPtr))
@@ -47,6 +69,92 @@ TRANSCEIVER_NAMES = {
     if r.is_file()
 }
 
+F_OSC = 32_000_000
+
+RADIO_PROFILES = {
+    # T1 and C1 share the channel, they are told apart by the first bytes of packet
+    "T1_C1": {
+        CONF_FREQUENCY: 868_950_000,
+        CONF_BITRATE: 100_000,
+        CONF_DEVIATION: 50_000,
+        CONF_BANDWIDTH: 125_000,
+        "sync_word": [0x54, 0x3D],
+        "manchester": False,
+        "link_mode": LinkMode.UNKNOWN,
+    },
+    # Manchester coded at 32.768 kcps, sync word aligned with 6 preamble chips
+    "S1": {
+        CONF_FREQUENCY: 868_300_000,
+        CONF_BITRATE: 32_768,
+        CONF_DEVIATION: 50_000,
+        CONF_BANDWIDTH: 100_000,
+        "sync_word": [0x54, 0x76, 0x96],
+        "manchester": True,
+        "link_mode": LinkMode.S1,
+    },
+}
+
+
+def sx1276_bandwidth(bandwidth):
+    # Smallest single side bandwidth not lower than requested
+    # BW = F_OSC / (mantissa * 2^(exponent + 2))
+    options = [
+        (F_OSC / (mantissa * 2 ** (exponent + 2)), (code << 3) | exponent)
+        for code, mantissa in enumerate((16, 20, 24))
+        for exponent in range(8)
+    ]
+    return min(
+        (o for o in options if o[0] >= bandwidth),
+        default=max(options),
+        key=lambda o: o[0],
+    )[1]
+
+
+def sx1276_profile(profile, frequency, bitrate, deviation, bandwidth):
+    frf = frequency * 2**19 // F_OSC
+    fdev = deviation * 2**19 // F_OSC
+    br = (F_OSC << 4) // bitrate
+    br_int, br_frac = br >> 4, br & 0x0F
+    rx_bw = sx1276_bandwidth(bandwidth)
+    sync_word = profile["sync_word"]
+
+    def array(values):
+        return cg.RawExpression("{{" + ", ".join(f"0x{v:02X}" for v in values) + "}}")
+
+    return cg.StructInitializer(
+        SX1276Profile,
+        ("frequency", frequency),
+        ("bitrate", bitrate),
+        (
+            "modem",
+            array(
+                [
+                    (br_int >> 8) & 0xFF,
+                    br_int & 0xFF,
+                    (fdev >> 8) & 0x3F,
+                    fdev & 0xFF,
+                    (frf >> 16) & 0xFF,
+                    (frf >> 8) & 0xFF,
+                    frf & 0xFF,
+                ]
+            ),
+        ),
+        ("bandwidth", array([rx_bw, rx_bw])),
+        ("bitrate_frac", br_frac),
+        ("packet_config", (0b01 << 5) if profile["manchester"] else 0),
+        ("sync_size", len(sync_word)),
+        ("sync_word", array(sync_word + [0] * (3 - len(sync_word)))),
+    )
+
+
+def validate_core(value):
+    value = cv.int_range(min=0, max=1)(value)
+    variant = get_esp32_variant()
+    if value > 0 and variant not in (VARIANT_ESP32, VARIANT_ESP32S3, VARIANT_ESP32P4):
+        raise cv.Invalid(f"{variant} has a single core, only core 0 can be used")
+    return value
+
+
 CONFIG_SCHEMA = (
     cv.Schema(
         {
@@ -55,6 +163,36 @@ CONFIG_SCHEMA = (
             cv.Required(CONF_RADIO_TYPE): cv.one_of(*TRANSCEIVER_NAMES, upper=True),
             cv.Required(CONF_RESET_PIN): pins.internal_gpio_output_pin_schema,
             cv.Required(CONF_IRQ_PIN): pins.internal_gpio_input_pin_schema,
+            cv.Optional(CONF_RADIO_PROFILE, default="T1_C1"): cv.one_of(
+                *RADIO_PROFILES, upper=True
+            ),
+            cv.Optional(CONF_FREQUENCY): cv.All(
+                cv.frequency, cv.float_range(min=137e6, max=1020e6)
+            ),
+            cv.Optional(CONF_BITRATE): cv.int_range(min=1200, max=300_000),
+            cv.Optional(CONF_DEVIATION): cv.All(
+                cv.frequency, cv.float_range(min=600, max=200e3)
+            ),
+            cv.Optional(CONF_BANDWIDTH): cv.All(
+                cv.frequency, cv.float_range(min=2.6e3, max=250e3)
+            ),
+            cv.Optional(CONF_QUEUE_SIZE, default=3): cv.int_range(min=1, max=32),
+            cv.Optional(CONF_ADDRESS_FILTER, default=False): cv.boolean,
+            cv.Optional(
+                CONF_DUPLICATE_WINDOW, default="0s"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(
+                CONF_LOOP_BUDGET, default="5ms"
+            ): cv.positive_time_period_microseconds,
+            cv.Optional(CONF_PROCESSING_TASK): cv.Schema(
+                {
+                    cv.Optional(CONF_STACK_SIZE, default=8192): cv.int_range(
+                        min=4096, max=32768
+                    ),
+                    cv.Optional(CONF_PRIORITY, default=1): cv.int_range(min=1, max=24),
+                    cv.Optional(CONF_CORE): validate_core,
+                }
+            ),
             cv.Optional(CONF_ON_FRAME): automation.validate_automation(
                 {
                     cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(FrameTrigger),
@@ -68,7 +206,7 @@ CONFIG_SCHEMA = (
             ),
         }
     )
-    .extend(spi.spi_device_schema())
+    .extend(spi.spi_device_schema(default_data_rate="8MHz"))
     .extend(cv.COMPONENT_SCHEMA)
 )
 
@@ -87,12 +225,40 @@ async def to_code(config):
     irq_pin = await cg.gpio_pin_expression(config[CONF_IRQ_PIN])
     cg.add(radio_var.set_irq_pin(irq_pin))
 
+    # Register values are computed here and stored as constant table in flash
+    profile = RADIO_PROFILES[config[CONF_RADIO_PROFILE]]
+    profile_values = sx1276_profile(
+        profile,
+        int(config.get(CONF_FREQUENCY, profile[CONF_FREQUENCY])),
+        config.get(CONF_BITRATE, profile[CONF_BITRATE]),
+        int(config.get(CONF_DEVIATION, profile[CONF_DEVIATION])),
+        int(config.get(CONF_BANDWIDTH, profile[CONF_BANDWIDTH])),
+    )
+    profile_id = f"{config[CONF_RADIO_ID]}_profile"
+    cg.add_global(
+        cg.RawStatement(
+            f"static constexpr {SX1276Profile} {profile_id} = {profile_values};"
+        )
+    )
+    cg.add(radio_var.set_profile(cg.RawExpression(f"&{profile_id}")))
+
     await spi.register_spi_device(radio_var, config)
     await cg.register_component(radio_var, config)
 
     cg.add(cg.LineComment("WMBus Component"))
     var = cg.new_Pvariable(config[CONF_ID])
     cg.add(var.set_radio(radio_var))
+    cg.add(var.set_queue_size(config[CONF_QUEUE_SIZE]))
+    cg.add(var.set_link_mode(profile["link_mode"]))
+    cg.add(var.set_address_filter(config[CONF_ADDRESS_FILTER]))
+    cg.add(var.set_duplicate_window(config[CONF_DUPLICATE_WINDOW]))
+    cg.add(var.set_loop_budget(config[CONF_LOOP_BUDGET]))
+
+    if task_config := config.get(CONF_PROCESSING_TASK):
+        args = [task_config[CONF_STACK_SIZE], task_config[CONF_PRIORITY]]
+        if CONF_CORE in task_config:
+            args.append(task_config[CONF_CORE])
+        cg.add(var.set_processing_task(*args))
 
     await cg.register_component(var, config)
 
@@ -1,7 +1,10 @@
 #include "component.h"
 
+#include "esp_timer.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
+
+#include <algorithm>
+#include <array>
 
 #include "esphome/core/helpers.h"
 
@@ -22,89 +25,304 @@ namespace wmbus_radio {
 static const char *TAG = "wmbus";
 
 void Radio::setup() {
-  ASSERT_SETUP((this->packet_queue_ = xQueueCreate(3, sizeof(Packet *))) != nullptr);
+  this->packet_queue_.init(this->queue_size_);
 
   ASSERT_SETUP(xTaskCreate((TaskFunction_t) this->receiver_task, "radio_recv", 3 * 1024, this, 2,
                            &(this->receiver_task_handle_)));
 
   ESP_LOGI(TAG, "Receiver task created [%p]", this->receiver_task_handle_);
 
-  this->radio->attach_data_interrupt(Radio::wakeup_receiver_task_from_isr, &(this->receiver_task_handle_));
+  if (this->processing_task_config_.has_value()) {
+    auto &config = *this->processing_task_config_;
+    ASSERT_SETUP(xTaskCreatePinnedToCore((TaskFunction_t) this->processing_task, "radio_proc", config.stack_size,
+                                         this, config.priority, &(this->processing_task_handle_),
+                                         config.core.value_or(tskNO_AFFINITY)));
+
+    ESP_LOGI(TAG, "Processing task created [%p]", this->processing_task_handle_);
+
+    if (this->has_packet_callbacks_ || !this->frame_handlers_.empty())
+      this->deferred_queue_.init(this->queue_size_);
+  }
+
+  this->radio->attach_data_interrupt(Radio::wakeup_receiver_task_from_isr, this);
 }
 
 void Radio::loop() {
-  Packet *p;
-  if (xQueueReceive(this->packet_queue_, &p, 0) != pdPASS)
+  // With processing task enabled, main loop only runs deferred automations/publishing
+  if (this->processing_task_handle_ != nullptr) {
+    this->run_deferred_automations();
     return;
+  }
+
+  // Drain as many packets as fit in time budget, at least one
+  auto start = micros();
+  while (this->process_packet())
+    if (micros() - start >= this->loop_budget_us_)
+      break;
 
-  this->on_packet_callback_manager(p);
+  // Come back sooner if something is still waiting
+  if (this->packet_queue_.size())
+    this->high_freq_.start();
+  else
+    this->high_freq_.stop();
+}
 
-  auto frame = p->convert_to_frame();
+bool Radio::process_packet() {
+  auto p = this->packet_queue_.front();
+  if (p == nullptr)
+    return false;
 
-  if (!frame)
-    return;
+  this->handle_packet(p);
+  // Frame refers to packet buffer, so the slot is given back only when all handlers are done
+  this->packet_queue_.pop();
+  return true;
+}
+
+void Radio::handle_packet(Packet *p) {
+  if (this->has_packet_callbacks_ && this->processing_task_handle_ == nullptr)
+    this->on_packet_callback_manager(p);
+
+  // Packets failing CRC are queued only for on_packet, receiver counted them already
+  auto frame = p->is_raw_only() ? std::nullopt : p->convert_to_frame();
+  bool to_frame_handlers = false;
+  if (frame)
+    to_frame_handlers = this->handle_frame(&frame.value());
+  else if (!p->is_raw_only())
+    increment(this->stats_.invalid_frames);
+
+  // Automations are not thread safe, with processing task they run on main loop from a copy of the packet,
+  // as its slot is reused before main loop gets to it
+  if (this->deferred_queue_.depth() && (this->has_packet_callbacks_ || to_frame_handlers)) {
+    auto deferred = this->deferred_queue_.producer_slot();
+    // Slot buffer is preallocated for the longest packet, so copying it does not allocate
+    // Packet data already is the converted frame, main loop only wraps it
+    deferred->packet = *p;
+    deferred->run_frame_handlers = to_frame_handlers;
+    deferred->frame_handlers_count = to_frame_handlers ? frame->frame_handlers_count() : 0;
+    if (!this->deferred_queue_.push())
+      ESP_LOGW(TAG, "Automations are falling behind (%u packets skipped so far)", this->deferred_queue_.dropped());
+  }
+}
 
+// Returns true if frame still has to be passed to on_frame handlers on main loop
+bool Radio::handle_frame(Frame *frame) {
   ESP_LOGI(TAG, "Frame created (%zu bytes) [RSSI: %d, mode:%s%s]", frame->data().size(), frame->rssi(),
            toString(frame->link_mode()), toString(frame->block_type()));
 
-  uint8_t packet_handled = 0;
-  for (auto &handler : this->frame_handlers_)
-    handler(&frame.value());
+  auto dll_id = frame->dll_id();
+  if (this->duplicate_filter_.check(dll_id, frame->data(), millis())) {
+    ESP_LOGD(TAG, "Duplicate frame from %08X suppressed", dll_id);
+    increment(this->stats_.duplicate_frames);
+    this->for_each_meter(frame, [](MeterHandlers &meter) { increment(meter.suppressed_duplicates); });
+    return false;
+  }
+
+  bool deferred = this->processing_task_handle_ != nullptr && !this->frame_handlers_.empty();
+  auto handler_start = micros();
+  if (!deferred)
+    for (auto &handler : this->frame_handlers_)
+      handler(frame);
+
+  // Meters parse telegram here and defer only publishing to main loop
+  this->dispatch_to_meters(frame);
+  this->stats_.handler.add(micros() - handler_start);
+
+  // Deferred frames are counted once on_frame handlers had their chance to mark them as handled
+  if (!deferred)
+    this->count_handled_frame(frame->frame_handlers_count());
+  return deferred;
+}
+
+void Radio::count_handled_frame(uint8_t handlers_count) {
+  ESP_LOGI(TAG, "Telegram handled by %d handlers", handlers_count);
+  increment(handlers_count ? this->stats_.handled_frames : this->stats_.unhandled_frames);
+}
+
+void Radio::run_deferred_automations() {
+  while (auto deferred = this->deferred_queue_.front()) {
+    if (this->has_packet_callbacks_)
+      this->on_packet_callback_manager(&deferred->packet);
+
+    if (deferred->run_frame_handlers) {
+      // Frame refers to the copied packet, which stays in its slot until all handlers are done
+      Frame frame(&deferred->packet);
+      for (auto &handler : this->frame_handlers_)
+        handler(&frame);
+      this->count_handled_frame(deferred->frame_handlers_count + frame.frame_handlers_count());
+    }
+    this->deferred_queue_.pop();
+  }
+}
+
+void Radio::processing_task(Radio *arg) {
+  while (true) {
+    // Woken up by receiver task, timeout is just a safety net
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+    while (arg->process_packet())
+      ;
+  }
+}
+
+static void dump_histogram(const char *name, const TimingHistogram &histogram) {
+  if (!histogram.count())
+    return;
+  ESP_LOGCONFIG(TAG, "  %s time: %u samples, max %u us", name, histogram.count(), histogram.max_us());
+  for (size_t i = 0; i < TimingHistogram::BUCKETS; i++)
+    if (histogram.bucket(i))
+      ESP_LOGCONFIG(TAG, "    < %u us: %u", TimingHistogram::bucket_limit_us(i), histogram.bucket(i));
+}
 
-  ESP_LOGI(TAG, "Telegram handled by %d handlers", frame->frame_handlers_count());
+void Radio::dump_config() {
+  ESP_LOGCONFIG(TAG, "wM-Bus Radio:");
+  ESP_LOGCONFIG(TAG, "  Queue size: %zu", this->packet_queue_.depth());
+  if (this->processing_task_config_.has_value()) {
+    auto &config = *this->processing_task_config_;
+    ESP_LOGCONFIG(TAG, "  Processing task: priority %u, stack %u bytes, core %d", config.priority, config.stack_size,
+                  config.core.value_or(-1));
+  }
+  if (this->processing_task_handle_ == nullptr)
+    ESP_LOGCONFIG(TAG, "  Loop time budget: %u us", this->loop_budget_us_);
+  ESP_LOGCONFIG(TAG, "  Queue high watermark: %zu", this->packet_queue_.high_watermark());
+  ESP_LOGCONFIG(TAG, "  Dropped packets: %u", this->packet_queue_.dropped());
+  if (this->deferred_queue_.depth())
+    ESP_LOGCONFIG(TAG, "  Dropped automations: %u", this->deferred_queue_.dropped());
+  if (this->address_filter_)
+    ESP_LOGCONFIG(TAG, "  Address filter: %zu meters, %u frames rejected", this->allowed_meter_ids_.size(),
+                  this->stats_.address_rejected.load());
+  if (this->duplicate_filter_.is_enabled()) {
+    ESP_LOGCONFIG(TAG, "  Suppressed duplicates: %u", this->stats_.duplicate_frames.load());
+    for (auto &it : this->meter_frame_handlers_)
+      ESP_LOGCONFIG(TAG, "    %08X: %u", it.first, it.second.suppressed_duplicates.load());
+  }
+  ESP_LOGCONFIG(TAG, "  Packets: %u received, %u preamble errors, %u length errors, %u read errors, %u CRC errors",
+                this->stats_.received_packets.load(), this->stats_.preamble_errors.load(),
+                this->stats_.length_errors.load(), this->stats_.read_errors.load(), this->stats_.crc_errors.load());
+  ESP_LOGCONFIG(TAG, "  Frames: %u handled, %u unhandled, %u invalid", this->stats_.handled_frames.load(),
+                this->stats_.unhandled_frames.load(), this->stats_.invalid_frames.load());
+  dump_histogram("RX restart", this->stats_.restart_rx);
+  dump_histogram("SPI read", this->stats_.spi_read);
+  dump_histogram("Decode", this->stats_.decode);
+  dump_histogram("Handler", this->stats_.handler);
 }
 
-void IRAM_ATTR Radio::wakeup_receiver_task_from_isr(TaskHandle_t *arg) {
+void IRAM_ATTR Radio::wakeup_receiver_task_from_isr(Radio *arg) {
+  arg->irq_timestamp_us_ = esp_timer_get_time();
   BaseType_t xHigherPriorityTaskWoken;
-  vTaskNotifyGiveFromISR(*arg, &xHigherPriorityTaskWoken);
+  vTaskNotifyGiveFromISR(arg->receiver_task_handle_, &xHigherPriorityTaskWoken);
   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 void Radio::receive_frame() {
+  auto restart_start = micros();
+  auto restart_timestamp_us = esp_timer_get_time();
   this->radio->restart_rx();
+  this->stats_.restart_rx.add(micros() - restart_start);
 
-  auto packet = std::make_unique<Packet>();
+  // Packet buffer is preallocated, so no heap allocation happens on receive path
+  auto packet = this->packet_queue_.producer_slot();
+  // Raw copy is kept only for on_packet, frames are decoded in place
+  packet->reset(this->link_mode_, this->has_packet_callbacks_);
 
   if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(60000))) {
+    increment(this->stats_.interrupt_timeouts);
     ESP_LOGD(TAG, "Radio interrupt timeout");
     return;
   }
 
-  if (!this->radio->read(packet->rx_data_ptr(), packet->rx_capacity())) {
+  // First interrupt marks the moment FIFO started filling with packet data
+  // If restart_rx notified the task itself (data already waiting), there was no fresh interrupt
+  int64_t irq_timestamp_us = this->irq_timestamp_us_;
+  packet->set_rx_timestamp(irq_timestamp_us >= restart_timestamp_us ? irq_timestamp_us : esp_timer_get_time());
+
+  uint32_t spi_read_us = 0, decode_us = 0;
+  auto rx_ptr = packet->rx_data_ptr();
+  auto read_start = micros();
+  auto read_ok = this->radio->read(rx_ptr, packet->rx_capacity());
+  spi_read_us += micros() - read_start;
+  if (!read_ok) {
+    increment(this->stats_.preamble_errors);
     ESP_LOGV(TAG, "Failed to read preamble");
     return;
   }
 
   if (!packet->validate_preamble()) {
+    increment(this->stats_.preamble_errors);
     ESP_LOGV(TAG, "Received invalid preamble: [%s]", format_hex_pretty(packet->get_raw_data()).c_str());
     return;
   }
 
   if (!packet->calculate_payload_size()) {
+    increment(this->stats_.length_errors);
     ESP_LOGV(TAG, "Cannot calculate payload size");
     return;
   }
 
+  // Let transceiver end reception by itself and be ready for the next packet immediately
+  this->radio->set_payload_length(packet->rx_total_size());
+
   packet->set_rssi(this->radio->get_rssi());
 
-  if (!this->radio->read(packet->rx_data_ptr(), packet->rx_capacity())) {
-    ESP_LOGW(TAG, "Failed to read data");
-    return;
+  // Read block by block and verify each one as soon as it arrives
+  // On first invalid block give up, so RX is restarted without draining the rest of the frame,
+  // unless the raw packet is kept for on_packet
+  while (!packet->is_complete()) {
+    rx_ptr = packet->rx_data_ptr();
+    read_start = micros();
+    read_ok = this->radio->read(rx_ptr, packet->rx_capacity());
+    auto decode_start = micros();
+    spi_read_us += decode_start - read_start;
+    if (!read_ok) {
+      increment(this->stats_.read_errors);
+      ESP_LOGW(TAG, "Failed to read data");
+      return;
+    }
+
+    auto block_ok = packet->verify_block();
+    decode_us += micros() - decode_start;
+    if (!block_ok) {
+      increment(this->stats_.crc_errors);
+      if (!packet->keeps_raw()) {
+        ESP_LOGD(TAG, "Invalid block received, aborting");
+        return;
+      }
+      // on_packet gets packets failing CRC too, so the rest is received without verification
+      ESP_LOGD(TAG, "Invalid block received, receiving rest for on_packet");
+      packet->skip_verification();
+      read_start = micros();
+      read_ok = this->radio->read(packet->rx_data_ptr(), packet->rx_capacity());
+      spi_read_us += micros() - read_start;
+      if (!read_ok) {
+        increment(this->stats_.read_errors);
+        ESP_LOGW(TAG, "Failed to read data");
+        return;
+      }
+      packet->copy_raw();
+      break;
+    }
+
+    // Address is known after the first block, don't waste time on frames from foreign meters
+    if (!this->is_address_allowed(packet)) {
+      increment(this->stats_.address_rejected);
+      ESP_LOGV(TAG, "Frame from not configured meter, aborting");
+      return;
+    }
   }
 
-  auto packet_ptr = packet.get();
+  this->stats_.spi_read.add(spi_read_us);
+  this->stats_.decode.add(decode_us);
 
-  if (xQueueSend(this->packet_queue_, &packet_ptr, 0) == pdTRUE) {
-    ESP_LOGV(TAG, "Queue items: %zu", uxQueueMessagesWaiting(this->packet_queue_));
+  if (this->packet_queue_.push()) {
+    increment(this->stats_.received_packets);
+    ESP_LOGV(TAG, "Queue items: %zu", this->packet_queue_.size());
     ESP_LOGV(TAG, "Queue send success");
-    packet.release();
+    if (this->processing_task_handle_ != nullptr)
+      xTaskNotifyGive(this->processing_task_handle_);
   } else
-    ESP_LOGW(TAG, "Queue send failed");
+    ESP_LOGW(TAG, "Queue send failed (%u packets dropped so far)", this->packet_queue_.dropped());
 }
 
 void Radio::receiver_task(Radio *arg) {
   ESP_LOGE(TAG, "Hello from radio task!");
-  int counter = 0;
   while (true)
     arg->receive_frame();
 }
@@ -113,7 +331,63 @@ void Radio::add_frame_handler(std::function<void(Frame *)> &&callback) {
   this->frame_handlers_.push_back(std::move(callback));
 }
 
+void Radio::add_frame_handler(uint32_t meter_id, std::function<void(Frame *)> &&callback) {
+  this->meter_frame_handlers_[meter_id].handlers.push_back(std::move(callback));
+
+  auto it = std::lower_bound(this->allowed_meter_ids_.begin(), this->allowed_meter_ids_.end(), meter_id);
+  if (it == this->allowed_meter_ids_.end() || *it != meter_id)
+    this->allowed_meter_ids_.insert(it, meter_id);
+}
+
+uint32_t Radio::get_suppressed_duplicates(uint32_t meter_id) {
+  auto it = this->meter_frame_handlers_.find(meter_id);
+  if (it == this->meter_frame_handlers_.end())
+    return 0;
+  return it->second.suppressed_duplicates.load();
+}
+
+template<typename F> void Radio::for_each_meter(Frame *frame, F &&callback) {
+  if (this->meter_frame_handlers_.empty())
+    return;
+
+  // Header is parsed once per frame instead of once per meter
+  // DLL, ELL and TPL addresses fit in fixed array, more (never seen) ones are not checked for repeated IDs
+  std::array<uint32_t, 4> ids;
+  size_t ids_count = 0;
+  for (auto &address : frame->addresses()) {
+    char *end;
+    uint32_t id = std::strtoul(address.id.c_str(), &end, 16);
+    if (*end != '\0' || std::find(ids.begin(), ids.begin() + ids_count, id) != ids.begin() + ids_count)
+      continue;
+    if (ids_count < ids.size())
+      ids[ids_count++] = id;
+
+    auto it = this->meter_frame_handlers_.find(id);
+    if (it != this->meter_frame_handlers_.end())
+      callback(it->second);
+  }
+}
+
+void Radio::dispatch_to_meters(Frame *frame) {
+  this->for_each_meter(frame, [frame](MeterHandlers &meter) {
+    for (auto &handler : meter.handlers)
+      handler(frame);
+  });
+}
+
+bool Radio::is_address_allowed(Packet *packet) {
+  if (!this->address_filter_ || this->allowed_meter_ids_.empty())
+    return true;
+
+  auto meter_id = packet->dll_id();
+  if (!meter_id.has_value())
+    return true;
+
+  return std::binary_search(this->allowed_meter_ids_.begin(), this->allowed_meter_ids_.end(), *meter_id);
+}
+
 void Radio::on_packet(std::function<void(Packet *)> &&callback) {
+  this->has_packet_callbacks_ = true;
   this->on_packet_callback_manager.add(std::move(callback));
 }
 
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <unordered_map>
 
 #include "freertos/FreeRTOS.h"
 
@@ -9,34 +11,107 @@
 
 #include "esphome/components/spi/spi.h"
 
+#include "duplicate_filter.h"
 #include "packet.h"
+#include "packet_queue.h"
+#include "stats.h"
 #include "transceiver.h"
 
 namespace esphome {
 namespace wmbus_radio {
 
+struct ProcessingTaskConfig {
+  uint32_t stack_size;
+  uint8_t priority;
+  optional<int> core;
+};
+
 class Radio : public Component {
  public:
   void set_radio(RadioTransceiver *radio) { this->radio = radio; };
+  void set_queue_size(size_t queue_size) { this->queue_size_ = queue_size; };
+  // Link mode fixed by radio profile, UNKNOWN if it is detected from packet
+  void set_link_mode(LinkMode link_mode) { this->link_mode_ = link_mode; };
+  void set_address_filter(bool address_filter) { this->address_filter_ = address_filter; };
+  void set_duplicate_window(uint32_t window_ms) { this->duplicate_filter_.set_window(window_ms); };
+  void set_loop_budget(uint32_t loop_budget_us) { this->loop_budget_us_ = loop_budget_us; };
+  void set_processing_task(uint32_t stack_size, uint8_t priority, optional<int> core = {}) {
+    this->processing_task_config_ = ProcessingTaskConfig{stack_size, priority, core};
+  };
 
   void setup() override;
   void loop() override;
+  void dump_config() override;
   void receive_frame();
 
+  // Handler called for every frame
   void add_frame_handler(std::function<void(Frame *)> &&callback);
+  // Handler called only for frames containing given meter ID in any of their addresses
+  void add_frame_handler(uint32_t meter_id, std::function<void(Frame *)> &&callback);
   void on_packet(std::function<void(Packet *)> &&callback);
 
+  const RadioStats &get_stats() const { return this->stats_; }
+  size_t get_queue_items() const { return this->packet_queue_.size(); }
+  size_t get_queue_high_watermark() const { return this->packet_queue_.high_watermark(); }
+  uint32_t get_queue_dropped() const { return this->packet_queue_.dropped(); }
+  // Packets whose automations were skipped, as main loop fell behind the processing task
+  uint32_t get_deferred_dropped() const { return this->deferred_queue_.dropped(); }
+  uint32_t get_suppressed_duplicates(uint32_t meter_id);
+
  protected:
-  static void wakeup_receiver_task_from_isr(TaskHandle_t *arg);
+  static void wakeup_receiver_task_from_isr(Radio *arg);
   static void receiver_task(Radio *arg);
+  static void processing_task(Radio *arg);
+  bool process_packet();
+  void handle_packet(Packet *packet);
+  bool handle_frame(Frame *frame);
+  void count_handled_frame(uint8_t handlers_count);
+  void run_deferred_automations();
 
   RadioTransceiver *radio{nullptr};
   TaskHandle_t receiver_task_handle_{nullptr};
-  QueueHandle_t packet_queue_{nullptr};
+  // esp_timer time of the last data interrupt, written by ISR
+  volatile int64_t irq_timestamp_us_{0};
+  // Conversion and parsing is done in main loop if not configured
+  optional<ProcessingTaskConfig> processing_task_config_;
+  TaskHandle_t processing_task_handle_{nullptr};
+  size_t queue_size_{3};
+  LinkMode link_mode_{LinkMode::UNKNOWN};
+  uint32_t loop_budget_us_{5000};
+  HighFrequencyLoopRequester high_freq_;
+  SPSCQueue<Packet> packet_queue_;
+
+  // Copies of packets for automations run on main loop when processing task is enabled
+  struct DeferredPacket {
+    Packet packet;
+    bool run_frame_handlers;
+    // Meters which marked the frame as handled in processing task
+    uint8_t frame_handlers_count;
+  };
+  SPSCQueue<DeferredPacket> deferred_queue_;
+
+  RadioStats stats_;
+
+  // Sorted IDs accepted when address filter is enabled
+  bool address_filter_{false};
+  std::vector<uint32_t> allowed_meter_ids_;
+  bool is_address_allowed(Packet *packet);
 
   std::vector<std::function<void(Frame *)>> frame_handlers_;
+  struct MeterHandlers {
+    std::vector<std::function<void(Frame *)>> handlers;
+    // Written by packet processing, read by sensors on main loop
+    std::atomic<uint32_t> suppressed_duplicates{0};
+  };
+  std::unordered_map<uint32_t, MeterHandlers> meter_frame_handlers_;
+  // Meters configured with any of the frame addresses (DLL, ELL, TPL), each one once
+  template<typename F> void for_each_meter(Frame *frame, F &&callback);
+  void dispatch_to_meters(Frame *frame);
+
+  DuplicateFilter duplicate_filter_;
 
   CallbackManager<void(Packet *)> on_packet_callback_manager;
+  bool has_packet_callbacks_{false};
 };
 }  // namespace wmbus_radio
 }  // namespace esphome
\ No newline at end of file
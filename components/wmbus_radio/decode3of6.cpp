@@ -1,56 +1,71 @@
 #include "decode3of6.h"
 
-#include <map>
-
-#include "esphome/core/log.h"
-#include "esphome/core/helpers.h"
+#include <array>
 
 namespace esphome {
 namespace wmbus_radio {
-static const char *TAG = "3of6";
-std::optional<std::vector<uint8_t>> decode3of6(std::vector<uint8_t> &coded_data) {
-  static const std::map<uint8_t, uint8_t> lookupTable = {
-      {0b010110, 0x0}, {0b001101, 0x1}, {0b001110, 0x2}, {0b001011, 0x3}, {0b011100, 0x4}, {0b011001, 0x5},
-      {0b011010, 0x6}, {0b010011, 0x7}, {0b101100, 0x8}, {0b100101, 0x9}, {0b100110, 0xA}, {0b100011, 0xB},
-      {0b110100, 0xC}, {0b110001, 0xD}, {0b110010, 0xE}, {0b101001, 0xF},
-  };
-
-  // ESP_LOGD(TAG, "Decoding 3of6 data: %s", format_hex(coded_data).c_str());
-
-  std::vector<uint8_t> decodedBytes;
-  auto segments = coded_data.size() * 8 / 6;
-  auto data = coded_data.data();
-
-  for (size_t i = 0; i < segments; i++) {
-    auto bit_idx = i * 6;
-    auto byte_idx = bit_idx / 8;
-    auto bit_offset = bit_idx % 8;
-
-    uint8_t code = (data[byte_idx] << bit_offset);
-    if (bit_offset > 0)
-      code |= (data[byte_idx + 1] >> (8 - bit_offset));
-    code >>= 2;
-
-    auto it = lookupTable.find(code);
-    if (it == lookupTable.end()) {
-      // ESP_LOGW(TAG, "Invalid code: 0x%02X", code);
-      return {};
-    }
-
-    if (i % 2 == 0)
-      decodedBytes.push_back(it->second << 4);
-    else
-      decodedBytes.back() |= it->second;
-  }
+static constexpr uint8_t INVALID_SYMBOL = 0xFF;
+
+static constexpr std::array<uint8_t, 64> make_lookup_table() {
+  std::array<uint8_t, 64> table{};
+  for (auto &entry : table)
+    entry = INVALID_SYMBOL;
+
+  table[0b010110] = 0x0;
+  table[0b001101] = 0x1;
+  table[0b001110] = 0x2;
+  table[0b001011] = 0x3;
+  table[0b011100] = 0x4;
+  table[0b011001] = 0x5;
+  table[0b011010] = 0x6;
+  table[0b010011] = 0x7;
+  table[0b101100] = 0x8;
+  table[0b100101] = 0x9;
+  table[0b100110] = 0xA;
+  table[0b100011] = 0xB;
+  table[0b110100] = 0xC;
+  table[0b110001] = 0xD;
+  table[0b110010] = 0xE;
+  table[0b101001] = 0xF;
 
-  // ESP_LOGV(TAG, "Successfully decoded %zu bytes", decodedBytes.size());
-  return decodedBytes;
+  return table;
 }
 
-size_t encoded_size(size_t decoded_size) {
-  // Every 2 bytes (4 nibbles by 6 bits = 24b) of decoded data is encoded into 3 bytes of coded data
-  // +1 for rounding up
-  return (3 * decoded_size + 1) / 2;
+static constexpr auto LOOKUP_TABLE = make_lookup_table();
+
+bool decode3of6(const uint8_t *coded, uint8_t *decoded, size_t decoded_size) {
+  // 3 coded bytes (4 symbols) -> 2 decoded bytes per step
+  for (size_t i = 0; i < decoded_size / 2; i++) {
+    uint32_t block = (coded[0] << 16) | (coded[1] << 8) | coded[2];
+    coded += 3;
+
+    uint8_t n0 = LOOKUP_TABLE[(block >> 18) & 0x3F];
+    uint8_t n1 = LOOKUP_TABLE[(block >> 12) & 0x3F];
+    uint8_t n2 = LOOKUP_TABLE[(block >> 6) & 0x3F];
+    uint8_t n3 = LOOKUP_TABLE[block & 0x3F];
+
+    // Valid symbols never set upper nibble, INVALID_SYMBOL does
+    if ((n0 | n1 | n2 | n3) & 0xF0)
+      return false;
+
+    *decoded++ = (n0 << 4) | n1;
+    *decoded++ = (n2 << 4) | n3;
+  }
+
+  // Odd number of bytes - last one is coded in 12 bits
+  if (decoded_size % 2) {
+    uint16_t block = (coded[0] << 8) | coded[1];
+
+    uint8_t n0 = LOOKUP_TABLE[(block >> 10) & 0x3F];
+    uint8_t n1 = LOOKUP_TABLE[(block >> 4) & 0x3F];
+
+    if ((n0 | n1) & 0xF0)
+      return false;
+
+    *decoded = (n0 << 4) | n1;
+  }
+
+  return true;
 }
 }  // namespace wmbus_radio
-}  // namespace esphome
\ No newline at end of file
+}  // namespace esphome
@@ -1,12 +1,19 @@
 #pragma once
 
-#include <vector>
+#include <cstddef>
 #include <cstdint>
-#include <optional>
 
 namespace esphome {
 namespace wmbus_radio {
-std::optional<std::vector<uint8_t>> decode3of6(std::vector<uint8_t> &coded_data);
-size_t encoded_size(size_t decoded_size);
+// Decodes first decoded_size bytes of 3 out of 6 coded data (reads encoded_size(decoded_size) bytes)
+// Decoding may be done in place (decoded == coded), as output never overtakes input
+// Returns false if invalid symbol was found
+bool decode3of6(const uint8_t *coded, uint8_t *decoded, size_t decoded_size);
+
+// Every 2 bytes (4 nibbles by 6 bits = 24b) of decoded data is encoded into 3 bytes of coded data
+// +1 for rounding up
+constexpr size_t encoded_size(size_t decoded_size) { return (3 * decoded_size + 1) / 2; }
+// Number of whole bytes which can be decoded from coded data of given size
+constexpr size_t decoded_size(size_t encoded_size) { return (encoded_size * 8 / 6 + 1) / 2; }
 }  // namespace wmbus_radio
-}  // namespace esphome
\ No newline at end of file
+}  // namespace esphome
@@ -0,0 +1,40 @@
+#include "duplicate_filter.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+bool DuplicateFilter::check(uint32_t meter_id, const std::vector<uint8_t> &data, uint32_t now) {
+  if (!this->is_enabled())
+    return false;
+
+  // FNV-1a over whole frame, so access number and payload are covered
+  uint32_t hash = 2166136261UL;
+  for (auto byte : data) {
+    hash ^= byte;
+    hash *= 16777619UL;
+  }
+
+  // Entry with the same key, free or least recently seen one is (re)used
+  Entry *oldest = &this->entries_[0];
+  for (size_t i = 0; i < this->size_; i++) {
+    auto &entry = this->entries_[i];
+    if (entry.meter_id == meter_id && entry.hash == hash) {
+      entry.last_seen = now;
+      // Window counts from the first copy, so repeated copies can't extend it forever
+      if (now - entry.timestamp < this->window_ms_)
+        return true;
+      entry.timestamp = now;
+      return false;
+    }
+    if (now - entry.last_seen > now - oldest->last_seen)
+      oldest = &entry;
+  }
+
+  if (this->size_ < CACHE_SIZE)
+    oldest = &this->entries_[this->size_++];
+  *oldest = {meter_id, hash, now, now};
+  return false;
+}
+
+}  // namespace wmbus_radio
+}  // namespace esphome
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace wmbus_radio {
+// Remembers recently seen frames to drop exact copies sent again by meter or repeaters
+class DuplicateFilter {
+ public:
+  void set_window(uint32_t window_ms) { this->window_ms_ = window_ms; }
+  bool is_enabled() const { return this->window_ms_ > 0; }
+
+  // Returns true if the same frame was seen within time window, otherwise remembers it
+  bool check(uint32_t meter_id, const std::vector<uint8_t> &data, uint32_t now);
+
+ protected:
+  static constexpr size_t CACHE_SIZE = 16;
+
+  struct Entry {
+    uint32_t meter_id;
+    uint32_t hash;
+    // First copy, window counts from it
+    uint32_t timestamp;
+    // Latest copy, the least recently seen entry is evicted
+    uint32_t last_seen;
+  };
+
+  uint32_t window_ms_{0};
+  std::array<Entry, CACHE_SIZE> entries_{};
+  // Entries in use, the rest is free
+  size_t size_{0};
+};
+
+}  // namespace wmbus_radio
+}  // namespace esphome
@@ -1,12 +1,14 @@
 #include "packet.h"
 
+#include <algorithm>
+#include <cstring>
 #include <ctime>
 
+#include "esp_timer.h"
+
 #include "esphome/core/helpers.h"
 #include "esphome/components/wmbus_common/meters.h"
 
-#include "decode3of6.h"
-
 // 3 bytes for mode C marks + len or first 3 bytes of mode T to decode into 2 bytes
 #define WMBUS_FRAME_PRELOAD_SIZE (3)
 
@@ -31,7 +33,29 @@ const char *toString(BlockType type) {
   }
 }
 
-Packet::Packet() { this->data_.reserve(WMBUS_FRAME_PRELOAD_SIZE); }
+Packet::Packet() {
+  this->data_.reserve(WMBUS_MAX_PACKET_SIZE);
+  this->reset();
+}
+
+// Prepare packet for next reception without releasing its buffer
+// Link mode is given when radio profile determines it (S1), otherwise it is detected from data (T1/C1)
+void Packet::reset(LinkMode link_mode, bool keep_raw) {
+  this->data_.clear();
+  this->keep_raw_ = keep_raw;
+  this->raw_.clear();
+  if (keep_raw)
+    this->raw_.reserve(WMBUS_MAX_PACKET_SIZE);
+  this->raw_only_ = false;
+  this->rx_target_size_ = WMBUS_FRAME_PRELOAD_SIZE;
+  this->expected_size_ = 0;
+  this->frame_size_ = 0;
+  this->verified_size_ = 0;
+  this->payload_size_ = 0;
+  this->link_mode_ = link_mode;
+  this->block_type_ = BlockType::UNKNOWN;
+  this->rssi_ = 0;
+}
 
 // Determine the link mode based on the first byte of the data
 LinkMode Packet::link_mode() {
@@ -49,7 +73,10 @@ LinkMode Packet::link_mode() {
 // Determine block type for C1 mode based on second byte of data
 BlockType Packet::block_type() {
   if (this->block_type_ == BlockType::UNKNOWN) {
-    if (this->link_mode() == LinkMode::C1) {
+    // S1 frames are always in format A
+    if (this->link_mode() == LinkMode::S1)
+      this->block_type_ = BlockType::A;
+    else if (this->link_mode() == LinkMode::C1) {
       switch (this->data_[1]) {
         case WMBUS_MODE_C_BLOCK_A_MARK:
           this->block_type_ = BlockType::A;
@@ -67,16 +94,19 @@ BlockType Packet::block_type() {
 }
 
 void Packet::set_rssi(int8_t rssi) { this->rssi_ = rssi; }
+void Packet::set_rx_timestamp(int64_t timestamp_us) { this->rx_timestamp_us_ = timestamp_us; }
 
 // Get value of L-field
 uint8_t Packet::l_field() {
   switch (this->link_mode()) {
     case LinkMode::C1:
+    case LinkMode::S1:
       return this->data_[0];
     case LinkMode::T1: {
-      auto decoded = decode3of6(this->data_);
-      if (decoded)
-        return (*decoded)[0];
+      // Decode only the first byte instead of whole packet
+      uint8_t l_field;
+      if (this->data_.size() >= encoded_size(1) && decode3of6(this->data_.data(), &l_field, 1))
+        return l_field;
     }
     default:
       break;
@@ -84,8 +114,8 @@ uint8_t Packet::l_field() {
   return 0;
 }
 
-size_t Packet::expected_size() {
-  if (!this->expected_size_) {
+size_t Packet::frame_size() {
+  if (!this->frame_size_) {
     // Format A
     //   L-field = length without CRC fields and without L (1 byte)
     // Format B
@@ -105,21 +135,32 @@ size_t Packet::expected_size() {
     // Add all extra fields, excluding the CRC fields + 2 CRC bytes for each block
     auto nrBytes = l_field + 1 + 2 * nrBlocks;
 
+    switch (this->block_type()) {
+      case BlockType::B:
+        this->frame_size_ = 1 + l_field;
+        break;
+      default:
+        // T1 frames are always in format A
+        this->frame_size_ = nrBytes;
+        break;
+    }
+  }
+  return this->frame_size_;
+}
+
+size_t Packet::expected_size() {
+  if (!this->expected_size_) {
     switch (this->link_mode()) {
       case LinkMode::C1:
-        switch (this->block_type()) {
-          case BlockType::A:
-            this->expected_size_ = nrBytes;
-            break;
-          case BlockType::B:
-            this->expected_size_ = 1 + l_field;
-            break;
-          default:
-            break;
-        }
+        if (this->block_type() != BlockType::UNKNOWN)
+          this->expected_size_ = this->frame_size();
+        break;
+      case LinkMode::S1:
+        // Manchester coding is removed by transceiver
+        this->expected_size_ = this->frame_size();
         break;
       case LinkMode::T1:
-        this->expected_size_ = encoded_size(nrBytes);
+        this->expected_size_ = encoded_size(this->frame_size());
         break;
       default:
         break;
@@ -128,10 +169,88 @@ size_t Packet::expected_size() {
   return this->expected_size_;
 }
 
+// Number of bytes received from transceiver after sync word, including trimmed preamble
+size_t Packet::rx_total_size() {
+  auto size = this->expected_size();
+  if (this->link_mode() == LinkMode::C1)
+    size += WMBUS_MODE_C_MARKS_LEN;
+  return size;
+}
+
+// DLL address ID (as hex number, like in meter_id), available once first block is verified
+optional<uint32_t> Packet::dll_id() {
+  // L, C, M (2 bytes), ID (4 bytes, LSB first), version, type
+  if (this->payload_size_ < 8)
+    return {};
+  auto data = this->data_.data();
+  return data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t) data[7] << 24);
+}
+
+// Number of raw (received) bytes needed to have first decoded_size bytes of frame
+size_t Packet::raw_size(size_t decoded_size) {
+  if (this->link_mode() == LinkMode::T1)
+    return std::min(encoded_size(decoded_size), this->expected_size());
+  return decoded_size;
+}
+
+// Offset (in decoded frame) of the end of block following already verified data, CRC included
+size_t Packet::next_block_end() {
+  size_t end;
+  if (this->block_type() == BlockType::B)
+    // Format B: first block up to 128 bytes, second block with the rest
+    end = this->verified_size_ < 128 ? 128 : this->frame_size();
+  else
+    // Format A: first block has 10 bytes, next ones up to 16 bytes
+    end = this->verified_size_ == 0 ? 12 : this->verified_size_ + 18;
+
+  return std::min(end, this->frame_size());
+}
+
+bool Packet::is_complete() { return this->verified_size_ && this->verified_size_ == this->frame_size(); }
+
+bool Packet::verify_block() {
+  auto begin = this->verified_size_;
+  auto end = this->next_block_end();
+
+  if (end < begin + 3 || this->data_.size() < this->raw_size(end))
+    return false;
+
+  this->copy_raw();
+  auto data = this->data_.data();
+
+  // Block starts at even decoded offset, so it is aligned to 3 coded bytes
+  // Decoded data is written in place, before not yet decoded part of the buffer
+  if (this->link_mode() == LinkMode::T1 && !decode3of6(data + encoded_size(begin), data + begin, end - begin)) {
+    ESP_LOGV(TAG, "Invalid 3 out of 6 symbol in block %zu-%zu", begin, end);
+    return false;
+  }
+
+  auto block_payload_size = end - begin - 2;
+  if (!crc16_EN13757_check(data + begin, block_payload_size)) {
+    ESP_LOGV(TAG, "Block %zu-%zu CRC mismatch", begin, end);
+    return false;
+  }
+
+  // CRC is not needed anymore, move block payload right after the previous one
+  // Payload never overtakes not yet verified data, which starts at end of this block
+  std::memmove(data + this->payload_size_, data + begin, block_payload_size);
+  this->payload_size_ += block_payload_size;
+  this->verified_size_ = end;
+
+  if (this->is_complete()) {
+    // Leave frame without CRCs, L-field of format B counted them, so it is set like wmbusmeters does when trimming
+    this->data_.resize(this->payload_size_);
+    this->data_[0] = this->payload_size_ - 1;
+  } else
+    this->rx_target_size_ = this->raw_size(this->next_block_end());
+
+  return true;
+}
+
 size_t Packet::rx_capacity() {
   // TODO: Remove side effects?
-  auto cap = this->data_.capacity() - this->data_.size();
-  this->data_.resize(this->data_.capacity());
+  auto cap = this->rx_target_size_ - this->data_.size();
+  this->data_.resize(this->rx_target_size_);
   return cap;
 }
 
@@ -139,7 +258,11 @@ uint8_t *Packet::rx_data_ptr() { return this->data_.data() + this->data_.size();
 
 bool Packet::calculate_payload_size() {
   auto total_length = this->expected_size();
-  this->data_.reserve(total_length);
+  if (total_length < this->data_.size() || total_length > this->data_.capacity())
+    return false;
+
+  // Receive only up to the end of first block, so it can be verified before the rest arrives
+  this->rx_target_size_ = std::max(this->raw_size(this->next_block_end()), this->data_.size());
   return total_length;
 }
 
@@ -154,7 +277,8 @@ bool Packet::validate_preamble() {
       }
       break;
     case LinkMode::T1:
-      // T1 frame has no block type
+    case LinkMode::S1:
+      // T1 and S1 frames have no block type mark
       is_preamble_valid = true;
       break;
     default:
@@ -179,68 +303,217 @@ void Packet::trim_preamble() {
 }
 
 std::optional<Frame> Packet::convert_to_frame() {
-  ESP_LOGD(TAG, "Try to make frame from packet %s%s of size %u", toString(this->link_mode()),
+  ESP_LOGD(TAG, "Try to make frame from packet %s%s of size %zu", toString(this->link_mode()),
            toString(this->block_type()), this->expected_size());
 
   std::optional<Frame> frame = {};
 
-  if (this->link_mode() == LinkMode::T1 && this->expected_size() == this->data_.size()) {
-    auto decoded_data = decode3of6(this->data_);
-    if (decoded_data)
-      this->data_ = decoded_data.value();
-  }
+  // Data was already decoded, CRC-verified and stripped of CRCs block by block during reception
+  if (!this->is_complete())
+    return frame;
 
-  removeAnyDLLCRCs(this->data_);
   int dummy;
   if (checkWMBusFrame(this->data_, (size_t *) &dummy, &dummy, &dummy, false) == FrameStatus::FullFrame)
     frame.emplace(this);
 
-  delete this;
-
   return frame;
 }
 
-const std::vector<uint8_t> &Packet::get_raw_data() const { return data_; }
+// Decoding overwrites only bytes copied already
+void Packet::copy_raw() {
+  if (this->keep_raw_ && this->raw_.size() < this->data_.size())
+    this->raw_.insert(this->raw_.end(), this->data_.begin() + this->raw_.size(), this->data_.end());
+}
+
+void Packet::skip_verification() {
+  this->raw_only_ = true;
+  this->rx_target_size_ = this->expected_size();
+}
+
+const std::vector<uint8_t> &Packet::get_raw_data() const { return this->keep_raw_ ? this->raw_ : this->data_; }
 
 Frame::Frame(Packet *packet)
-    : data_(std::move(packet->data_)),
+    : data_(&packet->data_),
       link_mode_(packet->link_mode_),
       block_type_(packet->block_type_),
-      rssi_(packet->rssi_) {}
-
-std::vector<uint8_t> &Frame::data() { return this->data_; }
+      rssi_(packet->rssi_),
+      rx_timestamp_us_(packet->rx_timestamp_us_) {}
+
+Frame::Frame(const Frame &other)
+    : owned_data_(*other.data_),
+      data_(&owned_data_),
+      link_mode_(other.link_mode_),
+      block_type_(other.block_type_),
+      rssi_(other.rssi_),
+      rx_timestamp_us_(other.rx_timestamp_us_),
+      addresses_(other.addresses_),
+      frame_handlers_count_(other.frame_handlers_count_) {}
+
+// Moved frame keeps referring to packet buffer, if it did so before
+Frame::Frame(Frame &&other)
+    : owned_data_(std::move(other.owned_data_)),
+      data_(other.data_ == &other.owned_data_ ? &owned_data_ : other.data_),
+      link_mode_(other.link_mode_),
+      block_type_(other.block_type_),
+      rssi_(other.rssi_),
+      rx_timestamp_us_(other.rx_timestamp_us_),
+      addresses_(std::move(other.addresses_)),
+      frame_handlers_count_(other.frame_handlers_count_) {}
+
+const std::vector<uint8_t> &Frame::data() const { return *this->data_; }
 LinkMode Frame::link_mode() { return this->link_mode_; }
 BlockType Frame::block_type() { return this->block_type_; }
 int8_t Frame::rssi() { return this->rssi_; }
+int64_t Frame::rx_timestamp_us() { return this->rx_timestamp_us_; }
+timeval Frame::rx_time() {
+  // Shift current wall clock back by time elapsed since reception
+  timeval now;
+  gettimeofday(&now, nullptr);
+  int64_t time_us = now.tv_sec * 1000000LL + now.tv_usec - (esp_timer_get_time() - this->rx_timestamp_us_);
+  now.tv_sec = time_us / 1000000;
+  now.tv_usec = time_us % 1000000;
+  return now;
+}
+
+const std::vector<uint8_t> &Frame::as_raw() const { return *this->data_; }
+std::string Frame::as_hex() { return this->format_to_string(HEX); }
+std::string Frame::as_rtlwmbus() { return this->format_to_string(RTLWMBUS); }
+
+static const char *link_mode_name(LinkMode link_mode) {
+#define X(name, lcname, option, val) \
+  if (link_mode == LinkMode::name) \
+    return #name;
+  LIST_OF_LINK_MODES
+#undef X
+  return "UnknownLinkMode";
+}
+
+static char *write_str(char *out, const char *str) {
+  while (*str)
+    *out++ = *str++;
+  return out;
+}
+
+static char *write_hex(char *out, const uint8_t *data, size_t size) {
+  static const char NIBBLES[] = "0123456789abcdef";
+  for (size_t i = 0; i < size; i++) {
+    *out++ = NIBBLES[data[i] >> 4];
+    *out++ = NIBBLES[data[i] & 0x0F];
+  }
+  return out;
+}
+
+static char *write_int(char *out, int value) {
+  if (value < 0) {
+    *out++ = '-';
+    value = -value;
+  }
+  char digits[4];
+  size_t n = 0;
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  while (n)
+    *out++ = digits[--n];
+  return out;
+}
+
+// Frames come in bursts within the same second, so date and time part is formatted only when second changes
+static char *write_rtlwmbus_time(char *out, const timeval &time) {
+  static time_t cached_second = -1;
+  static char cached_prefix[sizeof("YYYY-MM-DD HH:MM:SS")];
+  if (time.tv_sec != cached_second) {
+    std::strftime(cached_prefix, sizeof(cached_prefix), "%F %T", std::gmtime(&time.tv_sec));
+    cached_second = time.tv_sec;
+  }
+  out = write_str(out, cached_prefix);
+  auto centiseconds = time.tv_usec / 10000;
+  *out++ = '.';
+  *out++ = '0' + centiseconds / 10;
+  *out++ = '0' + centiseconds % 10;
+  *out++ = 'Z';
+  return out;
+}
+
+size_t Frame::formatted_size(OutputFormat format) const {
+  switch (format) {
+    case RAW:
+      return this->data_->size();
+    case HEX:
+      return 2 * this->data_->size();
+    case RTLWMBUS:
+      // Longest link mode name, time, RSSI and separators
+      return sizeof("UnknownLinkMode;1;1;YYYY-MM-DD HH:MM:SS.00Z;-128;;;0x\n") + 2 * this->data_->size();
+  }
+  return 0;
+}
 
-std::vector<uint8_t> Frame::as_raw() { return this->data_; }
-std::string Frame::as_hex() { return format_hex(this->data_); }
-std::string Frame::as_rtlwmbus() {
-  const size_t time_repr_size = sizeof("YYYY-MM-DD HH:MM:SS.00Z");
-  char time_buffer[time_repr_size];
-  auto t = std::time(NULL);
-  std::strftime(time_buffer, time_repr_size, "%F %T.00Z", std::gmtime(&t));
-
-  auto output = std::string{};
-  output.reserve(2 + 5 + 24 + 1 + 4 + 5 + 2 * this->data_.size() + 1);
-
-  output += linkModeName(this->link_mode_);  // size 2
-  output += ";1;1;";                         // size 5
-  output += time_buffer;                     // size 24
-  output += ';';                             // size 1
-  output += std::to_string(this->rssi_);     // size up to 4
-  output += ";;;0x";                         // size 5
-  output += this->as_hex();                  // size 2 * frame.size()
-  output += "\n";                            // size 1
+size_t Frame::format(OutputFormat format, char *buffer, size_t size) {
+  if (size < this->formatted_size(format))
+    return 0;
 
+  auto out = buffer;
+  switch (format) {
+    case RAW:
+      out = std::copy(this->data_->begin(), this->data_->end(), out);
+      break;
+    case HEX:
+      out = write_hex(out, this->data_->data(), this->data_->size());
+      break;
+    case RTLWMBUS:
+      out = write_str(out, link_mode_name(this->link_mode_));
+      out = write_str(out, ";1;1;");
+      out = write_rtlwmbus_time(out, this->rx_time());
+      *out++ = ';';
+      out = write_int(out, this->rssi_);
+      out = write_str(out, ";;;0x");
+      out = write_hex(out, this->data_->data(), this->data_->size());
+      *out++ = '\n';
+      break;
+  }
+  return out - buffer;
+}
+
+std::string Frame::format_to_string(OutputFormat format) {
+  // Single allocation of the result, no intermediate strings
+  std::string output(this->formatted_size(format), '\0');
+  output.resize(this->format(format, &output[0], output.size()));
   return output;
 }
+
+// Telegram header is parsed on first use and shared by all consumers of the frame
+const std::vector<Address> &Frame::addresses() {
+  if (!this->addresses_.has_value()) {
+    Telegram telegram;
+    telegram.parseWMBUSHeader(*this->data_);
+    this->addresses_ = std::move(telegram.addresses);
+  }
+  return *this->addresses_;
+}
+
 std::string Frame::meter_id() {
-  Telegram telegram;
-  telegram.parseWMBUSHeader(this->data_);
-  return telegram.addresses[0].str();
+  auto &addresses = this->addresses();
+  if (addresses.empty())
+    return {};
+  // Address::str() is not const
+  auto address = addresses.front();
+  return address.str();
+}
+
+// DLL address ID (as hex number, like in meter_id)
+uint32_t Frame::dll_id() {
+  // Frame is at least 11 bytes long, as checked by checkWMBusFrame
+  auto &data = this->data();
+  return data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t) data[7] << 24);
 }
 
+// Remaining DLL fields are at fixed positions, no parsing needed
+uint16_t Frame::manufacturer() { return this->data()[2] | (this->data()[3] << 8); }
+uint8_t Frame::version() { return this->data()[8]; }
+uint8_t Frame::device_type() { return this->data()[9]; }
+uint8_t Frame::ci_field() { return this->data()[10]; }
+
 void Frame::mark_as_handled() { this->frame_handlers_count_++; }
 uint8_t Frame::frame_handlers_count() { return this->frame_handlers_count_; }
 
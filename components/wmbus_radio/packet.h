@@ -6,14 +6,23 @@
 #include <string>
 #include <vector>
 
+#include <sys/time.h>
+
 #include "esphome/core/helpers.h"
 #include "esphome/components/wmbus_common/wmbus.h"
 
+#include "decode3of6.h"
+
 namespace esphome {
 namespace wmbus_radio {
 
 enum class BlockType { UNKNOWN = 0, A = 1, B = 2 };
 
+// Longest possible frame (L-field = 255) with CRC fields: 1 + 255 + 2 * 17 blocks
+static constexpr size_t WMBUS_MAX_FRAME_SIZE = 290;
+// Longest possible packet received from radio (3 out of 6 encoded T1 frame)
+static constexpr size_t WMBUS_MAX_PACKET_SIZE = encoded_size(WMBUS_MAX_FRAME_SIZE);
+
 const char *toString(BlockType type);
 
 struct Frame;
@@ -23,22 +32,55 @@ struct Packet {
 
  public:
   Packet();
+  void reset(LinkMode link_mode = LinkMode::UNKNOWN, bool keep_raw = false);
 
   uint8_t *rx_data_ptr();
   size_t rx_capacity();
   bool calculate_payload_size();
+  size_t rx_total_size();
+  optional<uint32_t> dll_id();
+  bool verify_block();
+  bool is_complete();
+  // Give up on verification after invalid block, the rest is received only for the raw copy
+  void skip_verification();
+  bool is_raw_only() const { return this->raw_only_; }
+  bool keeps_raw() const { return this->keep_raw_; }
+  // Append bytes received since previous call to the raw copy, before they are decoded in place
+  void copy_raw();
   void set_rssi(int8_t rssi);
+  void set_rx_timestamp(int64_t timestamp_us);
   bool validate_preamble();
 
   std::optional<Frame> convert_to_frame();
+  // Packet as received (3 out of 6 coded, with CRCs), when raw copy is kept
   const std::vector<uint8_t> &get_raw_data() const;
 
  protected:
+  // Reserved once for WMBUS_MAX_PACKET_SIZE, never reallocated
   std::vector<uint8_t> data_;
 
+  // Copy of received bytes before they are decoded in place, kept for on_packet
+  // Reserved on first use for WMBUS_MAX_PACKET_SIZE, never reallocated
+  bool keep_raw_ = false;
+  std::vector<uint8_t> raw_;
+  bool raw_only_ = false;
+  size_t rx_target_size_ = 0;
+
+  // Decoded frame size with CRC fields
+  size_t frame_size();
+  size_t frame_size_ = 0;
+
+  // Raw (possibly 3 out of 6 coded) packet size
   size_t expected_size();
   size_t expected_size_ = 0;
 
+  // Offset (in decoded frame with CRCs) of the end of verified blocks
+  size_t verified_size_ = 0;
+  // Verified data with CRCs removed, kept at the beginning of data_
+  size_t payload_size_ = 0;
+  size_t next_block_end();
+  size_t raw_size(size_t decoded_size);
+
   LinkMode link_mode();
   LinkMode link_mode_ = LinkMode::UNKNOWN;
 
@@ -49,33 +91,69 @@ struct Packet {
   uint8_t l_field();
 
   int8_t rssi_;
+  int64_t rx_timestamp_us_ = 0;
 };
 
 struct Frame {
  public:
-  Frame(Packet *packet);
-  Frame(std::vector<uint8_t> data, LinkMode lm, BlockType bt, int8_t rssi)
-      : data_(std::move(data)), link_mode_(lm), block_type_(bt), rssi_(rssi){};
+  enum OutputFormat { HEX, RAW, RTLWMBUS };
 
-  std::vector<uint8_t> &data();
+  // Frame made from packet refers to packet buffer, so it is valid only until packet slot is released
+  Frame(Packet *packet);
+  Frame(std::vector<uint8_t> data, LinkMode lm, BlockType bt, int8_t rssi, int64_t rx_timestamp_us)
+      : owned_data_(std::move(data)),
+        data_(&owned_data_),
+        link_mode_(lm),
+        block_type_(bt),
+        rssi_(rssi),
+        rx_timestamp_us_(rx_timestamp_us){};
+  // Copy owns its data, so it can outlive the packet (e.g. when deferred to main loop)
+  Frame(const Frame &other);
+  Frame(Frame &&other);
+  Frame &operator=(const Frame &other) = delete;
+
+  // Read only view of frame bytes, shared by all handlers without copying
+  const std::vector<uint8_t> &data() const;
   LinkMode link_mode();
   BlockType block_type();
   int8_t rssi();
+  // Monotonic (esp_timer) time of reception
+  int64_t rx_timestamp_us();
+  // Wall clock time of reception
+  timeval rx_time();
 
-  std::vector<uint8_t> as_raw();
+  const std::vector<uint8_t> &as_raw() const;
   std::string as_hex();
   std::string as_rtlwmbus();
+  // Buffer size needed by format()
+  size_t formatted_size(OutputFormat format) const;
+  // Write frame in given format directly into buffer, returns number of bytes written (0 if buffer is too small)
+  // Not reentrant, as rtlwmbus timestamp prefix is cached between calls
+  size_t format(OutputFormat format, char *buffer, size_t size);
   std::string meter_id();
+  // All addresses (DLL, ELL, TPL) found in frame header
+  const std::vector<Address> &addresses();
+  uint32_t dll_id();
+  uint16_t manufacturer();
+  uint8_t version();
+  uint8_t device_type();
+  uint8_t ci_field();
 
   void mark_as_handled();
   uint8_t frame_handlers_count();
 
  protected:
-  std::vector<uint8_t> data_;
+  // Empty for frames referring to packet buffer
+  std::vector<uint8_t> owned_data_;
+  const std::vector<uint8_t> *data_;
   LinkMode link_mode_;
   BlockType block_type_;
   int8_t rssi_;
+  int64_t rx_timestamp_us_;
+  optional<std::vector<Address>> addresses_;
   uint8_t frame_handlers_count_ = 0;
+
+  std::string format_to_string(OutputFormat format);
 };
 
 }  // namespace wmbus_radio
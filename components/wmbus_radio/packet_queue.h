@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace esphome {
+namespace wmbus_radio {
+// Lock-free single-producer/single-consumer queue of preallocated slots.
+// Producer fills the slot returned by producer_slot() in place and commits it with push(),
+// consumer processes front() in place and releases it with pop().
+// Two extra slots are allocated: the producer always owns a slot not visible to the consumer,
+// and the consumer keeps the front slot until it is done with it, so depth slots stay free for waiting items.
+template<typename T> class SPSCQueue {
+ public:
+  // Allocates all slots, must be called once before queue is used
+  void init(size_t depth) {
+    this->capacity_ = depth + 2;
+    this->slots_ = std::make_unique<T[]>(this->capacity_);
+  }
+
+  // Slot owned by producer, never accessed by consumer until pushed
+  T *producer_slot() { return &this->slots_[this->head_.load(std::memory_order_relaxed)]; }
+
+  // Publish producer slot to consumer
+  // Returns false (and counts a drop) when queue is full
+  bool push() {
+    auto head = this->head_.load(std::memory_order_relaxed);
+    auto next = this->next(head);
+    if (next == this->tail_.load(std::memory_order_acquire)) {
+      this->dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    this->head_.store(next, std::memory_order_release);
+
+    auto items = this->size();
+    if (items > this->high_watermark_.load(std::memory_order_relaxed))
+      this->high_watermark_.store(items, std::memory_order_relaxed);
+
+    return true;
+  }
+
+  // Oldest pushed slot or nullptr if queue is empty
+  T *front() {
+    auto tail = this->tail_.load(std::memory_order_relaxed);
+    if (tail == this->head_.load(std::memory_order_acquire))
+      return nullptr;
+    return &this->slots_[tail];
+  }
+
+  // Give front slot back to producer
+  // Caller must ensure queue is not empty
+  void pop() {
+    auto tail = this->tail_.load(std::memory_order_relaxed);
+    this->tail_.store(this->next(tail), std::memory_order_release);
+  }
+
+  size_t size() const {
+    auto head = this->head_.load(std::memory_order_acquire);
+    auto tail = this->tail_.load(std::memory_order_acquire);
+    return head >= tail ? head - tail : this->capacity_ - tail + head;
+  }
+  size_t depth() const { return this->capacity_ ? this->capacity_ - 2 : 0; }
+  uint32_t dropped() const { return this->dropped_.load(std::memory_order_relaxed); }
+  size_t high_watermark() const { return this->high_watermark_.load(std::memory_order_relaxed); }
+
+ protected:
+  size_t next(size_t idx) const { return (idx + 1) % this->capacity_; }
+
+  std::unique_ptr<T[]> slots_;
+  size_t capacity_{0};
+
+  std::atomic<size_t> head_{0};  // Position of slot being filled by producer
+  std::atomic<size_t> tail_{0};  // Position of next slot to be consumed
+
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<size_t> high_watermark_{0};
+};
+
+}  // namespace wmbus_radio
+}  // namespace esphome
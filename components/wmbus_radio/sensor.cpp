@@ -0,0 +1,71 @@
+#include "sensor.h"
+#ifdef USE_SENSOR
+
+namespace esphome {
+namespace wmbus_radio {
+static const char *TAG = "wmbus_radio.sensor";
+
+static void publish_counter(sensor::Sensor *sensor, uint32_t value) {
+  if (sensor != nullptr)
+    sensor->publish_state(value);
+}
+
+void StatsSensor::publish_timing(sensor::Sensor *sensor, const TimingHistogram &histogram,
+                                 TimingSnapshot &snapshot) {
+  auto count = histogram.count();
+  auto total_us = histogram.total_us();
+  // Unsigned differences are fine even if total wrapped in the meantime
+  auto samples = count - snapshot.count;
+  auto duration_us = total_us - snapshot.total_us;
+  snapshot = {count, total_us};
+
+  if (sensor != nullptr && samples)
+    sensor->publish_state(float(duration_us) / samples);
+}
+
+void StatsSensor::update() {
+  auto &stats = this->parent_->get_stats();
+
+  publish_counter(this->received_packets_sensor_, stats.received_packets.load());
+  publish_counter(this->dropped_packets_sensor_, this->parent_->get_queue_dropped());
+  publish_counter(this->dropped_automations_sensor_, this->parent_->get_deferred_dropped());
+  publish_counter(this->preamble_errors_sensor_, stats.preamble_errors.load());
+  publish_counter(this->length_errors_sensor_, stats.length_errors.load());
+  publish_counter(this->read_errors_sensor_, stats.read_errors.load());
+  publish_counter(this->crc_errors_sensor_, stats.crc_errors.load());
+  publish_counter(this->address_rejected_sensor_, stats.address_rejected.load());
+  publish_counter(this->invalid_frames_sensor_, stats.invalid_frames.load());
+  publish_counter(this->duplicate_frames_sensor_, stats.duplicate_frames.load());
+  publish_counter(this->handled_frames_sensor_, stats.handled_frames.load());
+  publish_counter(this->unhandled_frames_sensor_, stats.unhandled_frames.load());
+
+  this->publish_timing(this->restart_rx_time_sensor_, stats.restart_rx, this->restart_rx_snapshot_);
+  this->publish_timing(this->spi_read_time_sensor_, stats.spi_read, this->spi_read_snapshot_);
+  this->publish_timing(this->decode_time_sensor_, stats.decode, this->decode_snapshot_);
+  this->publish_timing(this->handler_time_sensor_, stats.handler, this->handler_snapshot_);
+}
+
+void StatsSensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "wM-Bus Radio Statistics:");
+  LOG_UPDATE_INTERVAL(this);
+  LOG_SENSOR("  ", "Received packets", this->received_packets_sensor_);
+  LOG_SENSOR("  ", "Dropped packets", this->dropped_packets_sensor_);
+  LOG_SENSOR("  ", "Dropped automations", this->dropped_automations_sensor_);
+  LOG_SENSOR("  ", "Preamble errors", this->preamble_errors_sensor_);
+  LOG_SENSOR("  ", "Length errors", this->length_errors_sensor_);
+  LOG_SENSOR("  ", "Read errors", this->read_errors_sensor_);
+  LOG_SENSOR("  ", "CRC errors", this->crc_errors_sensor_);
+  LOG_SENSOR("  ", "Rejected by address", this->address_rejected_sensor_);
+  LOG_SENSOR("  ", "Invalid frames", this->invalid_frames_sensor_);
+  LOG_SENSOR("  ", "Duplicate frames", this->duplicate_frames_sensor_);
+  LOG_SENSOR("  ", "Handled frames", this->handled_frames_sensor_);
+  LOG_SENSOR("  ", "Unhandled frames", this->unhandled_frames_sensor_);
+  LOG_SENSOR("  ", "RX restart time", this->restart_rx_time_sensor_);
+  LOG_SENSOR("  ", "SPI read time", this->spi_read_time_sensor_);
+  LOG_SENSOR("  ", "Decode time", this->decode_time_sensor_);
+  LOG_SENSOR("  ", "Handler time", this->handler_time_sensor_);
+}
+
+}  // namespace wmbus_radio
+}  // namespace esphome
+#endif
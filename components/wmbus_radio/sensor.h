@@ -0,0 +1,58 @@
+#pragma once
+#include "esphome/core/defines.h"
+#ifdef USE_SENSOR
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+#include "component.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+#define STATS_SENSOR(name) \
+ public: \
+  void set_##name##_sensor(sensor::Sensor *sensor) { this->name##_sensor_ = sensor; } \
+\
+ protected: \
+  sensor::Sensor *name##_sensor_{nullptr};
+
+class StatsSensor : public PollingComponent, public Parented<Radio> {
+  STATS_SENSOR(received_packets)
+  STATS_SENSOR(dropped_packets)
+  STATS_SENSOR(dropped_automations)
+  STATS_SENSOR(preamble_errors)
+  STATS_SENSOR(length_errors)
+  STATS_SENSOR(read_errors)
+  STATS_SENSOR(crc_errors)
+  STATS_SENSOR(address_rejected)
+  STATS_SENSOR(invalid_frames)
+  STATS_SENSOR(duplicate_frames)
+  STATS_SENSOR(handled_frames)
+  STATS_SENSOR(unhandled_frames)
+  STATS_SENSOR(restart_rx_time)
+  STATS_SENSOR(spi_read_time)
+  STATS_SENSOR(decode_time)
+  STATS_SENSOR(handler_time)
+
+ public:
+  void update() override;
+  void dump_config() override;
+
+ protected:
+  // Snapshot of histogram taken on previous update, so average is calculated over update interval
+  struct TimingSnapshot {
+    uint32_t count{0};
+    uint32_t total_us{0};
+  };
+  void publish_timing(sensor::Sensor *sensor, const TimingHistogram &histogram, TimingSnapshot &snapshot);
+
+  TimingSnapshot restart_rx_snapshot_;
+  TimingSnapshot spi_read_snapshot_;
+  TimingSnapshot decode_snapshot_;
+  TimingSnapshot handler_snapshot_;
+};
+
+}  // namespace wmbus_radio
+}  // namespace esphome
+#endif
@@ -0,0 +1,77 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.const import (
+    CONF_ID,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+)
+
+from . import CONF_RADIO_ID, RadioComponent, radio_ns
+
+DEPENDENCIES = ["wmbus_radio"]
+
+UNIT_MICROSECOND = "µs"
+
+StatsSensor = radio_ns.class_("StatsSensor", cg.PollingComponent)
+
+COUNTERS = [
+    "received_packets",
+    "dropped_packets",
+    "dropped_automations",
+    "preamble_errors",
+    "length_errors",
+    "read_errors",
+    "crc_errors",
+    "address_rejected",
+    "invalid_frames",
+    "duplicate_frames",
+    "handled_frames",
+    "unhandled_frames",
+]
+
+TIMINGS = [
+    "restart_rx_time",
+    "spi_read_time",
+    "decode_time",
+    "handler_time",
+]
+
+CONFIG_SCHEMA = (
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(StatsSensor),
+            cv.GenerateID(CONF_RADIO_ID): cv.use_id(RadioComponent),
+            **{
+                cv.Optional(key): sensor.sensor_schema(
+                    accuracy_decimals=0,
+                    state_class=STATE_CLASS_TOTAL_INCREASING,
+                    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                )
+                for key in COUNTERS
+            },
+            **{
+                cv.Optional(key): sensor.sensor_schema(
+                    unit_of_measurement=UNIT_MICROSECOND,
+                    accuracy_decimals=0,
+                    state_class=STATE_CLASS_MEASUREMENT,
+                    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                )
+                for key in TIMINGS
+            },
+        }
+    )
+    .extend(cv.polling_component_schema("60s"))
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    await cg.register_parented(var, config[CONF_RADIO_ID])
+
+    for key in COUNTERS + TIMINGS:
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(var, f"set_{key}_sensor")(sens))
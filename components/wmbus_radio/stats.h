@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Every counter and histogram has exactly one writer task, so plain relaxed load/store pairs are enough
+// and no read-modify-write atomics (emulated with locks on some targets) are needed.
+// Readers from other tasks may see slightly stale values, but never torn ones.
+inline void increment(std::atomic<uint32_t> &counter, uint32_t value = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Histogram of durations with power of two microsecond buckets
+// Total is kept in 32 bits and wraps, consumers are expected to work on differences between snapshots
+class TimingHistogram {
+ public:
+  // Bucket N holds durations in range [2^(N-1), 2^N) us, last one everything above 16 ms
+  static constexpr size_t BUCKETS = 16;
+
+  void add(uint32_t duration_us) {
+    size_t idx = duration_us ? 32 - __builtin_clz(duration_us) : 0;
+    if (idx >= BUCKETS)
+      idx = BUCKETS - 1;
+    increment(this->buckets_[idx]);
+    increment(this->count_);
+    increment(this->total_us_, duration_us);
+    if (duration_us > this->max_us_.load(std::memory_order_relaxed))
+      this->max_us_.store(duration_us, std::memory_order_relaxed);
+  }
+
+  uint32_t count() const { return this->count_.load(std::memory_order_relaxed); }
+  uint32_t total_us() const { return this->total_us_.load(std::memory_order_relaxed); }
+  uint32_t max_us() const { return this->max_us_.load(std::memory_order_relaxed); }
+  uint32_t bucket(size_t idx) const { return this->buckets_[idx].load(std::memory_order_relaxed); }
+  // Upper bound (exclusive) of durations counted in given bucket
+  static uint32_t bucket_limit_us(size_t idx) { return 1u << idx; }
+
+ protected:
+  std::array<std::atomic<uint32_t>, BUCKETS> buckets_{};
+  std::atomic<uint32_t> count_{0};
+  std::atomic<uint32_t> total_us_{0};
+  std::atomic<uint32_t> max_us_{0};
+};
+
+struct RadioStats {
+  // Written by receiver task
+  std::atomic<uint32_t> interrupt_timeouts{0};
+  std::atomic<uint32_t> preamble_errors{0};
+  std::atomic<uint32_t> length_errors{0};
+  std::atomic<uint32_t> read_errors{0};
+  std::atomic<uint32_t> crc_errors{0};
+  std::atomic<uint32_t> address_rejected{0};
+  std::atomic<uint32_t> received_packets{0};
+  TimingHistogram restart_rx;
+  TimingHistogram spi_read;
+  TimingHistogram decode;
+
+  // Written by packet processing (main loop or processing task)
+  std::atomic<uint32_t> invalid_frames{0};
+  std::atomic<uint32_t> duplicate_frames{0};
+  TimingHistogram handler;
+  // Written where on_frame handlers run, main loop when they are deferred from processing task
+  std::atomic<uint32_t> handled_frames{0};
+  std::atomic<uint32_t> unhandled_frames{0};
+};
+
+}  // namespace wmbus_radio
+}  // namespace esphome
@@ -16,10 +16,13 @@ class RadioTransceiver : public Component,
   virtual void setup() override = 0;
   void dump_config() override;
 
+  // IRQ pin goes high when requested amount of data is available
   template<typename T> void attach_data_interrupt(void (*callback)(T *), T *arg) {
-    this->irq_pin_->attach_interrupt(callback, arg, gpio::INTERRUPT_FALLING_EDGE);
+    this->irq_pin_->attach_interrupt(callback, arg, gpio::INTERRUPT_RISING_EDGE);
   }
   virtual void restart_rx() = 0;
+  // Number of bytes following sync word, 0 for unlimited
+  virtual void set_payload_length(size_t length) = 0;
   virtual int8_t get_rssi() = 0;
   virtual const char *get_name() = 0;
 
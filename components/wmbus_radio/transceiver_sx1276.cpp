@@ -1,8 +1,13 @@
 #include "transceiver_sx1276.h"
 
+#include <algorithm>
+
 #include "esphome/core/log.h"
 
-#define F_OSC (32000000)
+#define MODE_READY_TIMEOUT_US (5000)
+
+// Auto AFC on RX trigger, AGC, RX trigger on PreambleDetect
+#define AGC_AFC_CONFIG ((1 << 4) | (1 << 3) | 0b110)
 
 namespace esphome {
 namespace wmbus_radio {
@@ -23,29 +28,7 @@ void SX1276::setup() {
     return;
   }
 
-  ESP_LOGVV(TAG, "setting radio frequency");
-  const uint32_t frequency = 868950000;
-
-  uint32_t frf = ((uint64_t) frequency * (1 << 19)) / F_OSC;
-  this->spi_write(0x06, {BYTE(frf, 2), BYTE(frf, 1), BYTE(frf, 0)});
-
-  // TODO: Calculate in some rational way
-  ESP_LOGVV(TAG, "setting radio bandwidth");
-  this->spi_write(0x12, {2, 2});
-
-  ESP_LOGVV(TAG, "set frequency deviation");
-  const uint16_t freq_dev = 50000;
-  uint16_t frd = ((uint64_t) freq_dev * (1 << 19)) / F_OSC;
-  this->spi_write(0x04, {BYTE(frd, 1), BYTE(frd, 0)});
-
-  ESP_LOGVV(TAG, "set bitrate");
-  const uint32_t bitrate = 100000;
-  uint32_t br = (F_OSC << 4) / bitrate;
-  // Fractional part of the bitrate
-  this->spi_write(0x5D, (uint8_t) (br & 0x0F));
-  br >>= 4;
-  // Integer part of the bitrate
-  this->spi_write(0x02, {BYTE(br, 1), BYTE(br, 0)});
+  this->apply_profile();
 
   ESP_LOGVV(TAG, "set preamble length");
   uint16_t preamble_length = 32 / 8;
@@ -56,28 +39,20 @@ void SX1276::setup() {
   this->spi_write(0x1F, preamble_detection);
 
   ESP_LOGVV(TAG, "enable auto agc/afc");
-  uint8_t agc_afc = (1 << 4) | (1 << 3) | 0b110;
-  this->spi_write(0x0D, agc_afc);
+  this->spi_write(0x0D, (uint8_t) AGC_AFC_CONFIG);
 
   ESP_LOGVV(TAG, "disable clock output");
   uint8_t clock_output = 0b111;
   this->spi_write(0x24, clock_output);
 
-  ESP_LOGVV(TAG, "set sync word and reverse preamble polarity");
-  uint8_t reverse_preamble_sync_bytes = (1 << 5) | (1 << 4) | (2 - 1);
-  this->spi_write(0x27, {reverse_preamble_sync_bytes, 0x54, 0x3D});
-
-  ESP_LOGVV(TAG, "disable crc check/fixed packet length");
-  uint8_t crc_check = 0;
-  this->spi_write(0x30, crc_check);
-
   ESP_LOGVV(TAG, "set unlimited packet mode/zero length");
   uint8_t packet_mode = 0;
   this->spi_write(0x32, packet_mode);
 
-  ESP_LOGVV(TAG, "set fifo empty flag on DIO1");
-  uint8_t fifo_empty_flag = 0b01 << 4;
-  this->spi_write(0x40, fifo_empty_flag);
+  ESP_LOGVV(TAG, "set fifo level flag on DIO1");
+  uint8_t fifo_level_flag = 0b00 << 4;
+  this->spi_write(0x40, fifo_level_flag);
+  this->set_fifo_threshold(1);
 
   ESP_LOGVV(TAG, "set RRSI smoothing");
   uint8_t rssi_smoothing = 0b111;
@@ -86,40 +61,132 @@ void SX1276::setup() {
   ESP_LOGV(TAG, "SX1276 setup done");
 }
 
+void SX1276::apply_profile() {
+  auto &profile = *this->profile_;
+
+  ESP_LOGVV(TAG, "set bitrate, frequency deviation and radio frequency");
+  this->delegate_->begin_transaction();
+  this->delegate_->transfer(0x80 | 0x02);
+  this->delegate_->write_array(profile.modem.data(), profile.modem.size());
+  this->delegate_->end_transaction();
+  this->spi_write(0x5D, profile.bitrate_frac);
+
+  ESP_LOGVV(TAG, "set radio bandwidth");
+  this->spi_write(0x12, {profile.bandwidth[0], profile.bandwidth[1]});
+
+  ESP_LOGVV(TAG, "set sync word, preamble polarity and auto restart RX after packet");
+  uint8_t sync_config = (0b01 << 6) | (1 << 5) | (1 << 4) | (profile.sync_size - 1);
+  this->spi_write(0x27, {sync_config, profile.sync_word[0], profile.sync_word[1], profile.sync_word[2]});
+
+  ESP_LOGVV(TAG, "set encoding, disable crc check/fixed packet length");
+  this->spi_write(0x30, profile.packet_config);
+
+  // FIFO read timeouts follow the bitrate, S mode at 32.768 kcps fills FIFO 6 times slower than T mode
+  this->byte_time_us_ = profile.byte_time_us();
+}
+
+void SX1276::dump_config() {
+  RadioTransceiver::dump_config();
+  ESP_LOGCONFIG(TAG, "  Frequency: %.3f MHz", this->profile_->frequency / 1e6f);
+  ESP_LOGCONFIG(TAG, "  Bitrate: %u cps%s, %u us per byte", this->profile_->bitrate,
+                this->profile_->manchester() ? " (Manchester)" : "", this->byte_time_us_);
+}
+
 bool IRAM_ATTR SX1276::read(uint8_t *buffer, size_t length) {
   while (length > 0) {
-    if (this->irq_pin_->digital_read()) {
-      if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1))) {
+    // Wait until FIFO holds whole chunk, then read it in single burst
+    size_t chunk = std::min<size_t>(length, SX1276_FIFO_CHUNK_SIZE);
+    this->set_fifo_threshold(chunk);
+
+    // Level is checked again, as notification may be left from previous chunk
+    while (!this->irq_pin_->digital_read())
+      if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sx1276_fifo_timeout_ms(this->byte_time_us_, chunk))))
         return false;
-      }
-    }
 
     this->delegate_->begin_transaction();
     this->delegate_->transfer(0x00);
-    while (length > 0 && !this->irq_pin_->digital_read()) {
-      *buffer++ = this->delegate_->transfer(0x00);
-      length--;
-    }
+    this->delegate_->read_array(buffer, chunk);
     this->delegate_->end_transaction();
+
+    buffer += chunk;
+    length -= chunk;
+    this->rx_bytes_ += chunk;
   }
 
   return true;
 }
 
+void SX1276::set_fifo_threshold(size_t bytes) {
+  // FifoLevel flag is set when FIFO contains more than threshold bytes
+  if (bytes == this->fifo_threshold_)
+    return;
+  this->spi_write(0x35, (uint8_t) ((1 << 7) | (bytes - 1)));
+  this->fifo_threshold_ = bytes;
+}
+
+void SX1276::set_payload_length(size_t length) {
+  // Fixed length mode - chip ends reception by itself after given number of bytes
+  // Length may be changed on the fly, as long as it is not reached yet
+  this->spi_write(0x31, {(uint8_t) ((1 << 6) | ((length >> 8) & 0b111)), BYTE(length, 0)});
+  this->payload_length_ = length;
+}
+
 void SX1276::restart_rx() {
-  // Standby mode
-  this->spi_write(0x01, (uint8_t) 0b001);
-  delay(5);
+  if (this->payload_length_ && this->rx_bytes_ == this->payload_length_) {
+    // Whole packet was read from FIFO, so chip has already restarted RX on its own
+    // No need for standby/FIFO clear round trip
+    this->rx_bytes_ = 0;
+    ulTaskNotifyTake(pdTRUE, 0);
+    this->set_fifo_threshold(1);
+
+    // Next packet may be already incoming, its edge could have been cleared above
+    if (this->irq_pin_->digital_read())
+      xTaskNotifyGive(xTaskGetCurrentTaskHandle());
+    return;
+  }
+
+  if (this->rx_enabled_) {
+    // Reception was aborted - drop the rest of packet without leaving RX mode
+    // Clear FIFO and restart receiver chain
+    this->spi_write(0x3F, (uint8_t) (1 << 4));
+    this->spi_write(0x0D, (uint8_t) (AGC_AFC_CONFIG | (1 << 6)));
+  } else {
+    // Standby mode
+    this->spi_write(0x01, (uint8_t) 0b001);
+    if (!this->wait_mode_ready())
+      ESP_LOGW(TAG, "Timeout while entering standby mode");
+
+    // Clear FIFO
+    this->spi_write(0x3F, (uint8_t) (1 << 4));
+  }
+
+  // Wake up on first received byte
+  this->set_fifo_threshold(1);
+  this->rx_bytes_ = 0;
 
-  // Clear FIFO
-  this->spi_write(0x3F, (uint8_t) (1 << 4));
+  // Back to unlimited length until L-field of next packet is known
+  if (this->payload_length_)
+    this->set_payload_length(0);
 
   // Clear pending IRQs we not consumed in read() method
   ulTaskNotifyTake(pdTRUE, 0);
 
-  // Enable RX
-  this->spi_write(0x01, (uint8_t) 0b101);
-  delay(5);
+  if (!this->rx_enabled_) {
+    // Enable RX
+    this->spi_write(0x01, (uint8_t) 0b101);
+    this->rx_enabled_ = this->wait_mode_ready();
+    if (!this->rx_enabled_)
+      ESP_LOGW(TAG, "Timeout while entering RX mode");
+  }
+}
+
+bool SX1276::wait_mode_ready() {
+  // ModeReady flag is set when requested mode is ready, usually within tens of microseconds
+  auto start = micros();
+  while (!(this->spi_read(0x3E) & (1 << 7)))
+    if (micros() - start > MODE_READY_TIMEOUT_US)
+      return false;
+  return true;
 }
 
 int8_t SX1276::get_rssi() {
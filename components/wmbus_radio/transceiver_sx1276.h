@@ -1,15 +1,70 @@
 #pragma once
+#include <array>
+
 #include "transceiver.h"
 
 namespace esphome {
 namespace wmbus_radio {
+
+// Bytes read from FIFO in single SPI burst, half of 64 bytes FIFO
+static constexpr size_t SX1276_FIFO_CHUNK_SIZE = 32;
+
+// Modem configuration for one radio profile, register values are computed at code generation time
+struct SX1276Profile {
+  uint32_t frequency;
+  uint32_t bitrate;
+  // RegBitrateMsb..RegFrfLsb (0x02-0x08): bitrate, frequency deviation and carrier frequency
+  std::array<uint8_t, 7> modem;
+  // RegRxBw, RegAfcBw (0x12-0x13)
+  std::array<uint8_t, 2> bandwidth;
+  // RegBitRateFrac (0x5D)
+  uint8_t bitrate_frac;
+  // RegPacketConfig1 (0x30), Manchester decoding for S mode
+  uint8_t packet_config;
+  // RegSyncConfig (0x27) with sync size, followed by up to 3 sync word bytes
+  uint8_t sync_size;
+  std::array<uint8_t, 3> sync_word;
+
+  bool manchester() const { return (this->packet_config & (0b11 << 5)) == (0b01 << 5); }
+  // Air time of one byte put into FIFO, rounded up; Manchester takes two chips per bit
+  uint32_t byte_time_us() const {
+    uint32_t chips = this->manchester() ? 16 : 8;
+    return (chips * 1000000 + this->bitrate - 1) / this->bitrate;
+  }
+};
+
+// How long to wait for given number of bytes to reach FIFO before giving up:
+// twice their air time, plus 2 ms for tick rounding and task latency
+inline uint32_t sx1276_fifo_timeout_ms(uint32_t byte_time_us, size_t bytes) {
+  return 2 + (bytes * byte_time_us * 2 + 999) / 1000;
+}
+
 class SX1276 : public RadioTransceiver {
  public:
+  void set_profile(const SX1276Profile *profile) { this->profile_ = profile; }
   void setup() override;
+  void dump_config() override;
   bool read(uint8_t *buffer, size_t length) override;
   void restart_rx() override;
+  void set_payload_length(size_t length) override;
   int8_t get_rssi() override;
   const char *get_name() override;
+
+ protected:
+  const SX1276Profile *profile_{nullptr};
+  void apply_profile();
+  uint32_t byte_time_us_{0};
+
+  bool wait_mode_ready();
+  bool rx_enabled_{false};
+
+  void set_fifo_threshold(size_t bytes);
+  size_t fifo_threshold_{0};
+
+  // Payload length programmed in fixed length mode, 0 in unlimited mode
+  size_t payload_length_{0};
+  // Bytes read from FIFO since RX was started
+  size_t rx_bytes_{0};
 };
 }  // namespace wmbus_radio
 }  // namespace esphome
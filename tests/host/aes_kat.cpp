@@ -0,0 +1,139 @@
+// Known answer tests of the AES backend compiled in (software AES, or mbedTLS when built with
+// AES_BACKEND_MBEDTLS): FIPS-197 and SP 800-38A block and CBC vectors, RFC 4493 AES-CMAC,
+// then the same vectors from several threads sharing one key.
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "esphome/components/wmbus_common/aescmac.h"
+#include "esphome/components/wmbus_common/util.h"
+
+static size_t failed = 0;
+
+static std::vector<uchar> from_hex(const char *hex) {
+  std::vector<uchar> bytes;
+  hex2bin(hex, &bytes);
+  return bytes;
+}
+
+static void check(const char *name, const std::vector<uchar> &result, const char *expected_hex) {
+  auto result_hex = bin2hex(result);
+  bool ok = result == from_hex(expected_hex);
+  std::printf("%-30s %s\n", name, ok ? "ok" : "FAILED");
+  if (!ok) {
+    std::printf("  expected %s\n  got      %s\n", expected_hex, result_hex.c_str());
+    failed++;
+  }
+}
+
+static std::vector<uchar> encrypt_blocks(const AESKey &key, const std::vector<uchar> &plain) {
+  std::vector<uchar> result(plain.size());
+  for (size_t offset = 0; offset < plain.size(); offset += 16)
+    key.encryptBlock(&plain[offset], &result[offset]);
+  return result;
+}
+
+static std::vector<uchar> decrypt_cbc(const AESKey &key, const std::vector<uchar> &cipher,
+                                      const std::vector<uchar> &iv) {
+  std::vector<uchar> result(cipher.size());
+  key.decryptCBC(cipher.data(), result.data(), cipher.size(), iv.data());
+  return result;
+}
+
+static std::vector<uchar> cmac(const AESKey &key, const std::vector<uchar> &message, size_t len) {
+  std::vector<uchar> mac(16);
+  AES_CMAC(key, message.data(), len, mac.data());
+  return mac;
+}
+
+// SP 800-38A F.1.1, F.2.2 and RFC 4493 use the same key and message
+static const char *SP800_38A_KEY = "2b7e151628aed2a6abf7158809cf4f3c";
+static const char *SP800_38A_PLAIN = "6bc1bee22e409f96e93d7e117393172a"
+                                     "ae2d8a571e03ac9c9eb76fac45af8e51"
+                                     "30c81c46a35ce411e5fbc1191a0a52ef"
+                                     "f69f2445df4f9b17ad2b417be66c3710";
+static const char *SP800_38A_ECB = "3ad77bb40d7a3660a89ecaf32466ef97"
+                                   "f5d3d58503b9699de785895a96fdbaaf"
+                                   "43b1cd7f598ece23881b00e3ed030688"
+                                   "7b0c785e27e8ad3f8223207104725dd4";
+static const char *SP800_38A_CBC_IV = "000102030405060708090a0b0c0d0e0f";
+static const char *SP800_38A_CBC = "7649abac8119b246cee98e9b12e9197d"
+                                   "5086cb9b507219ee95db113a917678b2"
+                                   "73bed6b8e3c1743b7116e69e22229516"
+                                   "3ff1caa1681fac09120eca307586e1a7";
+static const char *FIPS_197_KEY = "000102030405060708090a0b0c0d0e0f";
+static const char *FIPS_197_PLAIN = "00112233445566778899aabbccddeeff";
+static const char *FIPS_197_CIPHER = "69c4e0d86a7b0430d8cdb78070b4c55a";
+
+struct CMACVector {
+  size_t len;
+  const char *mac;
+};
+static const CMACVector RFC_4493_VECTORS[] = {
+    {0, "bb1d6929e95937287fa37d129b756746"},
+    {16, "070a16b46b4d4144f79bdd9dd04a287c"},
+    {40, "dfa66747de9ae63030ca32611497c827"},
+    {64, "51f0bebf7e3b9d92fc49741779363cfe"},
+};
+
+int main() {
+#if defined(AES_BACKEND_MBEDTLS)
+  std::printf("Backend: mbedTLS\n");
+#else
+  std::printf("Backend: software AES\n");
+#endif
+
+  AESKey fips_key(from_hex(FIPS_197_KEY));
+  AESKey key(from_hex(SP800_38A_KEY));
+  auto plain = from_hex(SP800_38A_PLAIN);
+  auto iv = from_hex(SP800_38A_CBC_IV);
+
+  check("FIPS-197 C.1 encrypt", encrypt_blocks(fips_key, from_hex(FIPS_197_PLAIN)), FIPS_197_CIPHER);
+  check("SP 800-38A F.1.1 ECB encrypt", encrypt_blocks(key, plain), SP800_38A_ECB);
+  check("SP 800-38A F.2.2 CBC decrypt", decrypt_cbc(key, from_hex(SP800_38A_CBC), iv), SP800_38A_PLAIN);
+  check("CBC decrypt keeps iv", iv, SP800_38A_CBC_IV);
+  for (auto &vector : RFC_4493_VECTORS) {
+    auto name = "RFC 4493 CMAC " + std::to_string(vector.len) + " bytes";
+    check(name.c_str(), cmac(key, plain, vector.len), vector.mac);
+  }
+
+  // Copies expand the key again instead of sharing the schedule of the original
+  AESKey copy;
+  {
+    AESKey original(from_hex(SP800_38A_KEY));
+    copy = original;
+  }
+  check("Copied key ECB encrypt", encrypt_blocks(copy, plain), SP800_38A_ECB);
+
+  AESKey short_key(from_hex("2b7e1516"));
+  bool short_key_unset = !short_key.isSet() && short_key.sameAs(from_hex("2b7e1516")) &&
+                         key.isSet() && key.sameAs(from_hex(SP800_38A_KEY));
+  std::printf("%-30s %s\n", "Key state", short_key_unset ? "ok" : "FAILED");
+  failed += !short_key_unset;
+
+  // Meters may decrypt from the processing task while the main loop uses the same keys
+  std::atomic<size_t> mismatches{0};
+  auto expected_ecb = from_hex(SP800_38A_ECB);
+  auto cbc = from_hex(SP800_38A_CBC);
+  auto expected_mac = from_hex(RFC_4493_VECTORS[3].mac);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 20000; i++) {
+        mismatches += encrypt_blocks(key, plain) != expected_ecb;
+        mismatches += decrypt_cbc(key, cbc, iv) != plain;
+        mismatches += cmac(key, plain, plain.size()) != expected_mac;
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  std::printf("%-30s %s\n", "Shared key from 4 threads", mismatches ? "FAILED" : "ok");
+  failed += mismatches != 0;
+
+  std::printf("%zu failed\n", failed);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+// Checks that receiving a packet and handing it to frame automations does not touch the heap,
+// in main loop mode as well as with processing task (where automations get a copy of the packet).
+// Dispatch to meters is not covered: parsing of frame header for addresses and telegram parsing
+// in wmbusmeters allocate.
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "esphome/components/wmbus_radio/component.h"
+
+#include "capture.h"
+#include "driver_tests.h"
+
+static std::atomic<bool> counting{false};
+static std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size) {
+  if (counting)
+    allocations++;
+  if (auto ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+using namespace esphome;
+using namespace esphome::wmbus_radio;
+
+// Gives access to packet handling without receiver and processing tasks
+class TestRadio : public Radio {
+ public:
+  void init_queues(bool processing_task) {
+    this->packet_queue_.init(this->queue_size_);
+    if (processing_task) {
+      // Never dereferenced, only tells packet handling that automations are deferred
+      this->processing_task_handle_ = reinterpret_cast<TaskHandle_t>(this);
+      this->deferred_queue_.init(this->queue_size_);
+    }
+  }
+  bool receive(const Capture &capture) {
+    auto packet = this->packet_queue_.producer_slot();
+    if (!receive_capture(*packet, capture))
+      return false;
+    return this->packet_queue_.push();
+  }
+  bool process() { return this->process_packet(); }
+  void run_automations() { this->run_deferred_automations(); }
+};
+
+static size_t run(const std::vector<Capture> &captures, bool processing_task, size_t *frames) {
+  TestRadio radio;
+  radio.init_queues(processing_task);
+
+  size_t hex_size = 0;
+  radio.on_packet([&](Packet *packet) { hex_size += packet->get_raw_data().size(); });
+  radio.add_frame_handler([&](Frame *frame) {
+    static char buffer[2 * WMBUS_MAX_FRAME_SIZE + 64];
+    hex_size += frame->format(Frame::RTLWMBUS, buffer, sizeof(buffer));
+    hex_size += frame->format(Frame::HEX, buffer, sizeof(buffer));
+    (*frames)++;
+  });
+
+  // First pass warms up lazily initialized state (time zone, static buffers), second one is counted
+  size_t result = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    allocations = 0;
+    counting = pass == 1;
+    *frames = 0;
+    for (auto &capture : captures) {
+      if (radio.receive(capture))
+        radio.process();
+      radio.run_automations();
+    }
+    counting = false;
+    result = allocations;
+  }
+  return result;
+}
+
+int main() {
+  std::vector<Capture> captures;
+  for (auto &test : load_driver_test_telegrams()) {
+    captures.push_back(make_capture(test.telegram, LinkMode::T1, BlockType::A));
+    captures.push_back(make_capture(test.telegram, LinkMode::C1, BlockType::A));
+    captures.push_back(make_capture(test.telegram, LinkMode::C1, BlockType::B));
+  }
+
+  int result = 0;
+  for (bool processing_task : {false, true}) {
+    size_t frames = 0;
+    auto count = run(captures, processing_task, &frames);
+    std::printf("%s: %zu frames, %zu allocations\n", processing_task ? "Processing task" : "Main loop", frames, count);
+    if (count || !frames)
+      result = 1;
+  }
+  return result;
+}
@@ -0,0 +1,31 @@
+#pragma once
+// Minimal benchmark helpers: time a callable and keep its results from being optimized away
+#include <chrono>
+#include <cstring>
+
+// Set by --quick (used by ctest): every benchmark runs just a few times, only correctness checks matter
+inline bool bench_quick = false;
+
+inline void parse_bench_args(int argc, char **argv) {
+  for (int i = 1; i < argc; i++)
+    if (std::strcmp(argv[i], "--quick") == 0)
+      bench_quick = true;
+}
+
+template<typename T> inline void do_not_optimize(const T &value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+// Calls fn repeatedly for about 200 ms, returns average time of one call in nanoseconds
+template<typename F> double measure_ns(F &&fn) {
+  using Clock = std::chrono::steady_clock;
+  auto min_time = bench_quick ? std::chrono::microseconds(100) : std::chrono::microseconds(200000);
+  size_t calls = 0;
+  auto start = Clock::now();
+  auto elapsed = Clock::duration::zero();
+  for (size_t batch = 1; elapsed < min_time; batch *= 2) {
+    for (size_t i = 0; i < batch; i++)
+      fn();
+    calls += batch;
+    elapsed = Clock::now() - start;
+  }
+  return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
@@ -0,0 +1,68 @@
+// Table driven CRC16 (EN 13757) against the original bit by bit one: same result for all lengths,
+// then time for whole frames and single blocks of real sizes.
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "esphome/components/wmbus_common/util.h"
+
+#include "bench.h"
+
+#define CRC16_EN_13757 0x3D65
+
+// CRC used before the lookup table, kept as reference
+static uint16_t reference_crc16_EN13757_per_byte(uint16_t crc, uchar b) {
+  unsigned char i;
+
+  for (i = 0; i < 8; i++) {
+    if (((crc & 0x8000) >> 8) ^ (b & 0x80)) {
+      crc = (crc << 1) ^ CRC16_EN_13757;
+    } else {
+      crc = (crc << 1);
+    }
+
+    b <<= 1;
+  }
+
+  return crc;
+}
+
+static uint16_t reference_crc16_EN13757(const uchar *data, size_t len) {
+  uint16_t crc = 0x0000;
+
+  for (size_t i = 0; i < len; ++i)
+    crc = reference_crc16_EN13757_per_byte(crc, data[i]);
+
+  return (~crc);
+}
+
+int main(int argc, char **argv) {
+  parse_bench_args(argc, argv);
+  std::mt19937 rng(1);
+
+  std::vector<uchar> data(300);
+  size_t checked = 0, failed = 0;
+  for (int round = 0; round < 100; round++) {
+    for (auto &byte : data)
+      byte = rng();
+    for (size_t len = 0; len < data.size(); len++, checked++) {
+      auto expected = reference_crc16_EN13757(data.data(), len);
+      auto crc = crc16_EN13757(data.data(), len);
+      if (crc != expected) {
+        std::printf("Mismatch for %zu bytes: reference %04X, table %04X\n", len, expected, crc);
+        failed++;
+      }
+    }
+  }
+  std::printf("Compared %zu CRCs with reference, %zu mismatches\n", checked, failed);
+
+  // Format A blocks (10 and 16 bytes), format B first block (126 bytes) and whole frames
+  std::printf("Bytes  reference (bitwise)  table\n");
+  for (size_t len : {10, 16, 31, 62, 126, 150, 290}) {
+    auto reference_ns = measure_ns([&]() { do_not_optimize(reference_crc16_EN13757(data.data(), len)); });
+    auto table_ns = measure_ns([&]() { do_not_optimize(crc16_EN13757(data.data(), len)); });
+    std::printf("%5zu  %16.0f ns  %5.0f ns\n", len, reference_ns, table_ns);
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,331 @@
+// Decryption of one telegram in security mode 5 (AES-CBC with IV), ELL AES-CTR and security mode 7
+// (KDF, AES-CMAC and AES-CBC without IV), as Telegram::parse does it:
+//   reference  the keyed tiny-AES calls used before AESKey, expanding the key for every call
+//              (once per block in CTR and CMAC)
+//   AESKey     the same AES operations with the key schedule cached in AESKey
+//   telegram   decrypt_* helpers on a Telegram with the cached key, including the frame copies
+// All three must give the same plaintext.
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "esphome/components/wmbus_common/aes.h"
+#include "esphome/components/wmbus_common/aescmac.h"
+#include "esphome/components/wmbus_common/wmbus_utils.h"
+
+#include "bench.h"
+
+static const uchar VEC87[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x87};
+
+// AES_CMAC as it was before AESKey, every block encrypted with the key taking tiny-AES call
+static void reference_cmac_subkey(const uchar *in, uchar *out) {
+  uchar shifted[16];
+  shiftLeft(const_cast<uchar *>(in), shifted, 16);
+  if (in[0] & 0x80)
+    xorit(shifted, VEC87, out, 16);
+  else
+    memcpy(out, shifted, 16);
+}
+
+static void reference_cmac(const uchar *key, const uchar *input, int len, uchar *mac) {
+  uchar zero[16] = {}, L[16], K1[16], K2[16], last[16], padded[16], X[16] = {}, Y[16];
+  AES_ECB_encrypt(zero, key, L, 16);
+  reference_cmac_subkey(L, K1);
+  reference_cmac_subkey(K1, K2);
+
+  int num_blocks = (len + 15) / 16;
+  bool complete = num_blocks && len % 16 == 0;
+  if (!num_blocks)
+    num_blocks = 1;
+  if (complete) {
+    xorit(input + 16 * (num_blocks - 1), K1, last, 16);
+  } else {
+    for (int i = 0; i < 16; i++)
+      padded[i] = i < len % 16 ? input[16 * (num_blocks - 1) + i] : (i == len % 16 ? 0x80 : 0);
+    xorit(padded, K2, last, 16);
+  }
+  for (int i = 0; i < num_blocks - 1; i++) {
+    xorit(X, input + 16 * i, Y, 16);
+    AES_ECB_encrypt(Y, key, X, 16);
+  }
+  xorit(X, last, Y, 16);
+  AES_ECB_encrypt(Y, key, mac, 16);
+}
+
+// Header bytes before pos in the frames, decryption starts after them
+static const size_t HEADER_SIZE = 15;
+
+struct Case {
+  std::vector<uchar> key;
+  std::vector<uchar> plain;
+  std::vector<uchar> frame;  // Header followed by the encrypted payload
+  Telegram telegram;
+};
+
+static void setup_telegram(Telegram &t, std::mt19937 &rng) {
+  for (auto &b : t.dll_mfct_b)
+    b = rng();
+  t.dll_a.resize(6);
+  for (auto &b : t.dll_a)
+    b = rng();
+  for (auto &b : t.dll_id_b)
+    b = rng();
+  for (auto &b : t.ell_sn_b)
+    b = rng();
+  for (auto &b : t.afl_counter_b)
+    b = rng();
+  t.ell_cc = rng();
+  t.tpl_acc = rng() & 0xff;
+  t.afl_mcl = 0x33;
+}
+
+static void fill_case(Case &c, size_t size, std::mt19937 &rng) {
+  c.key.resize(16);
+  for (auto &b : c.key)
+    b = rng();
+  c.plain.resize(size);
+  c.plain[0] = c.plain[1] = 0x2f;
+  for (size_t i = 2; i < size; i++)
+    c.plain[i] = rng();
+  c.frame.resize(HEADER_SIZE);
+  for (auto &b : c.frame)
+    b = rng();
+  setup_telegram(c.telegram, rng);
+  c.telegram.tpl_num_encr_blocks = size / 16;
+}
+
+static void mode5_iv(const Telegram &t, uchar *iv) {
+  memcpy(iv, t.dll_mfct_b, 2);
+  memcpy(iv + 2, t.dll_a.data(), 6);
+  memset(iv + 8, t.tpl_acc, 8);
+}
+
+static void ell_iv(const Telegram &t, uchar *iv) {
+  memcpy(iv, t.dll_mfct_b, 2);
+  memcpy(iv + 2, t.dll_a.data(), 6);
+  iv[8] = t.ell_cc & ~0x12;
+  memcpy(iv + 9, t.ell_sn_b, 4);
+  memset(iv + 13, 0, 3);
+}
+
+static void mode7_kdf_input(const Telegram &t, uchar derivation_constant, uchar *input) {
+  input[0] = derivation_constant;
+  memcpy(input + 1, t.afl_counter_b, 4);
+  memcpy(input + 5, t.dll_id_b, 4);
+  memset(input + 9, 0x07, 7);
+}
+
+static std::vector<uchar> mode7_mac_input(const Telegram &t, const std::vector<uchar> &frame) {
+  std::vector<uchar> input(5 + frame.size() - HEADER_SIZE);
+  input[0] = t.afl_mcl;
+  memcpy(&input[1], t.afl_counter_b, 4);
+  memcpy(&input[5], &frame[HEADER_SIZE], frame.size() - HEADER_SIZE);
+  return input;
+}
+
+// Old implementations, give the plaintext
+
+static std::vector<uchar> reference_mode5(const Case &c) {
+  uchar iv[16];
+  mode5_iv(c.telegram, iv);
+  std::vector<uchar> cipher(c.frame.begin() + HEADER_SIZE, c.frame.end());
+  std::vector<uchar> plain(cipher.size());
+  AES_CBC_decrypt_buffer(plain.data(), cipher.data(), cipher.size(), c.key.data(), iv);
+  return plain;
+}
+
+static std::vector<uchar> reference_ell(const Case &c) {
+  uchar iv[16], xordata[16];
+  ell_iv(c.telegram, iv);
+  std::vector<uchar> plain(c.frame.begin() + HEADER_SIZE, c.frame.end());
+  for (size_t offset = 0; offset < plain.size(); offset += 16) {
+    AES_ECB_encrypt(iv, c.key.data(), xordata, 16);
+    xorit(xordata, &plain[offset], &plain[offset], std::min<size_t>(16, plain.size() - offset));
+    incrementIV(iv, sizeof(iv));
+  }
+  return plain;
+}
+
+static std::vector<uchar> reference_mode7(const Case &c, bool *mac_ok) {
+  uchar input[16], kenc[16], kmac[16], mac[16], iv[16] = {};
+  mode7_kdf_input(c.telegram, 0x00, input);
+  reference_cmac(c.key.data(), input, 16, kenc);
+  mode7_kdf_input(c.telegram, 0x01, input);
+  reference_cmac(c.key.data(), input, 16, kmac);
+  auto mac_input = mode7_mac_input(c.telegram, c.frame);
+  reference_cmac(kmac, mac_input.data(), mac_input.size(), mac);
+  *mac_ok = memcmp(mac, c.telegram.afl_mac_b.data(), 8) == 0;
+
+  std::vector<uchar> cipher(c.frame.begin() + HEADER_SIZE, c.frame.end());
+  std::vector<uchar> plain(cipher.size());
+  AES_CBC_decrypt_buffer(plain.data(), cipher.data(), cipher.size(), kenc, iv);
+  return plain;
+}
+
+// Same operations with cached key schedules
+
+static std::vector<uchar> aeskey_mode5(const Case &c, const AESKey &key) {
+  uchar iv[16];
+  mode5_iv(c.telegram, iv);
+  std::vector<uchar> plain(c.frame.size() - HEADER_SIZE);
+  key.decryptCBC(&c.frame[HEADER_SIZE], plain.data(), plain.size(), iv);
+  return plain;
+}
+
+static std::vector<uchar> aeskey_ell(const Case &c, const AESKey &key) {
+  uchar iv[16], xordata[16];
+  ell_iv(c.telegram, iv);
+  std::vector<uchar> plain(c.frame.begin() + HEADER_SIZE, c.frame.end());
+  for (size_t offset = 0; offset < plain.size(); offset += 16) {
+    key.encryptBlock(iv, xordata);
+    xorit(xordata, &plain[offset], &plain[offset], std::min<size_t>(16, plain.size() - offset));
+    incrementIV(iv, sizeof(iv));
+  }
+  return plain;
+}
+
+// Ephemeral keys of mode 7, derived from the meter key once per telegram
+static void mode7_keys(const Case &c, const AESKey &key, std::vector<uchar> &kenc, std::vector<uchar> &kmac) {
+  uchar input[16];
+  kenc.resize(16);
+  kmac.resize(16);
+  mode7_kdf_input(c.telegram, 0x00, input);
+  AES_CMAC(key, input, 16, kenc.data());
+  mode7_kdf_input(c.telegram, 0x01, input);
+  AES_CMAC(key, input, 16, kmac.data());
+}
+
+static std::vector<uchar> aeskey_mode7(const Case &c, const AESKey &key, bool *mac_ok) {
+  std::vector<uchar> kenc, kmac;
+  mode7_keys(c, key, kenc, kmac);
+  uchar mac[16], iv[16] = {};
+  auto mac_input = mode7_mac_input(c.telegram, c.frame);
+  AES_CMAC(AESKey(kmac), mac_input.data(), mac_input.size(), mac);
+  *mac_ok = memcmp(mac, c.telegram.afl_mac_b.data(), 8) == 0;
+
+  std::vector<uchar> plain(c.frame.size() - HEADER_SIZE);
+  AESKey(kenc).decryptCBC(&c.frame[HEADER_SIZE], plain.data(), plain.size(), iv);
+  return plain;
+}
+
+// decrypt_* helpers, decrypt a copy of the frame like Telegram::parse decrypts its frame
+
+static std::vector<uchar> telegram_mode5(Case &c, const AESKey &key) {
+  std::vector<uchar> frame = c.frame;
+  auto pos = frame.begin() + HEADER_SIZE;
+  int num_encrypted_bytes = 0, num_not_encrypted_at_end = 0;
+  decrypt_TPL_AES_CBC_IV(&c.telegram, frame, pos, key, &num_encrypted_bytes, &num_not_encrypted_at_end);
+  return std::vector<uchar>(frame.begin() + HEADER_SIZE, frame.end());
+}
+
+static std::vector<uchar> telegram_ell(Case &c, const AESKey &key) {
+  std::vector<uchar> frame = c.frame;
+  auto pos = frame.begin() + HEADER_SIZE;
+  decrypt_ELL_AES_CTR(&c.telegram, frame, pos, key);
+  return std::vector<uchar>(frame.begin() + HEADER_SIZE, frame.end());
+}
+
+static std::vector<uchar> telegram_mode7(Case &c, const AESKey &key, bool *mac_ok) {
+  std::vector<uchar> kenc, kmac;
+  mode7_keys(c, key, kenc, kmac);
+  std::vector<uchar> frame = c.frame;
+  auto pos = frame.begin() + HEADER_SIZE;
+  // As Telegram::checkMAC compares the AFL MAC
+  auto mac_input = mode7_mac_input(c.telegram, frame);
+  std::vector<uchar> mac(16);
+  AES_CMAC(AESKey(kmac), mac_input.data(), mac_input.size(), mac.data());
+  *mac_ok = bin2hex(mac).substr(0, 16) == bin2hex(c.telegram.afl_mac_b);
+  int num_encrypted_bytes = 0, num_not_encrypted_at_end = 0;
+  decrypt_TPL_AES_CBC_NO_IV(&c.telegram, frame, pos, AESKey(kenc), &num_encrypted_bytes, &num_not_encrypted_at_end);
+  return std::vector<uchar>(frame.begin() + HEADER_SIZE, frame.end());
+}
+
+// Encrypted frames for the plaintext of each case
+
+static void encrypt_mode5(Case &c) {
+  uchar iv[16];
+  mode5_iv(c.telegram, iv);
+  std::vector<uchar> cipher(c.plain.size());
+  AES_CBC_encrypt_buffer(cipher.data(), c.plain.data(), c.plain.size(), c.key.data(), iv);
+  c.frame.insert(c.frame.end(), cipher.begin(), cipher.end());
+}
+
+static void encrypt_ell(Case &c) {
+  // CTR mode is its own inverse
+  c.frame.insert(c.frame.end(), c.plain.begin(), c.plain.end());
+  auto cipher = reference_ell(c);
+  std::copy(cipher.begin(), cipher.end(), c.frame.begin() + HEADER_SIZE);
+}
+
+static void encrypt_mode7(Case &c) {
+  uchar input[16], kenc[16], kmac[16], mac[16], iv[16] = {};
+  mode7_kdf_input(c.telegram, 0x00, input);
+  reference_cmac(c.key.data(), input, 16, kenc);
+  mode7_kdf_input(c.telegram, 0x01, input);
+  reference_cmac(c.key.data(), input, 16, kmac);
+  std::vector<uchar> cipher(c.plain.size());
+  AES_CBC_encrypt_buffer(cipher.data(), c.plain.data(), c.plain.size(), kenc, iv);
+  c.frame.insert(c.frame.end(), cipher.begin(), cipher.end());
+  auto mac_input = mode7_mac_input(c.telegram, c.frame);
+  reference_cmac(kmac, mac_input.data(), mac_input.size(), mac);
+  c.telegram.afl_mac_b.assign(mac, mac + 8);
+}
+
+static size_t failed = 0;
+
+static void check(const char *mode, size_t size, const char *variant, const std::vector<uchar> &plain,
+                  const Case &c, bool mac_ok = true) {
+  if (plain == c.plain && mac_ok)
+    return;
+  std::printf("%s %zu bytes: %s gives wrong %s\n", mode, size, variant, mac_ok ? "plaintext" : "mac");
+  failed++;
+}
+
+int main(int argc, char **argv) {
+  parse_bench_args(argc, argv);
+  std::mt19937 rng(1);
+
+  std::printf("Mode     Bytes  reference  AESKey     telegram\n");
+  for (size_t size : {32, 64, 128}) {
+    Case mode5, ell, mode7;
+    fill_case(mode5, size, rng);
+    fill_case(ell, size, rng);
+    fill_case(mode7, size, rng);
+    // ELL payloads need not be whole blocks
+    ell.plain.resize(size - 3);
+    encrypt_mode5(mode5);
+    encrypt_ell(ell);
+    encrypt_mode7(mode7);
+    AESKey mode5_key(mode5.key), ell_key(ell.key), mode7_key(mode7.key);
+
+    bool mac_ok = false;
+    check("mode 5", size, "reference", reference_mode5(mode5), mode5);
+    check("mode 5", size, "AESKey", aeskey_mode5(mode5, mode5_key), mode5);
+    check("mode 5", size, "telegram", telegram_mode5(mode5, mode5_key), mode5);
+    check("ELL", size, "reference", reference_ell(ell), ell);
+    check("ELL", size, "AESKey", aeskey_ell(ell, ell_key), ell);
+    check("ELL", size, "telegram", telegram_ell(ell, ell_key), ell);
+    auto plain = reference_mode7(mode7, &mac_ok);
+    check("mode 7", size, "reference", plain, mode7, mac_ok);
+    plain = aeskey_mode7(mode7, mode7_key, &mac_ok);
+    check("mode 7", size, "AESKey", plain, mode7, mac_ok);
+    plain = telegram_mode7(mode7, mode7_key, &mac_ok);
+    check("mode 7", size, "telegram", plain, mode7, mac_ok);
+
+    auto print = [&](const char *mode, double reference_ns, double aeskey_ns, double telegram_ns) {
+      std::printf("%-7s %6zu  %6.0f ns  %6.0f ns  %6.0f ns\n", mode, size, reference_ns, aeskey_ns, telegram_ns);
+    };
+    print("mode 5", measure_ns([&]() { do_not_optimize(reference_mode5(mode5)); }),
+          measure_ns([&]() { do_not_optimize(aeskey_mode5(mode5, mode5_key)); }),
+          measure_ns([&]() { do_not_optimize(telegram_mode5(mode5, mode5_key)); }));
+    print("ELL", measure_ns([&]() { do_not_optimize(reference_ell(ell)); }),
+          measure_ns([&]() { do_not_optimize(aeskey_ell(ell, ell_key)); }),
+          measure_ns([&]() { do_not_optimize(telegram_ell(ell, ell_key)); }));
+    print("mode 7", measure_ns([&]() { do_not_optimize(reference_mode7(mode7, &mac_ok)); }),
+          measure_ns([&]() { do_not_optimize(aeskey_mode7(mode7, mode7_key, &mac_ok)); }),
+          measure_ns([&]() { do_not_optimize(telegram_mode7(mode7, mode7_key, &mac_ok)); }));
+  }
+
+  return failed ? 1 : 0;
+}
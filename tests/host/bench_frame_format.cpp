@@ -0,0 +1,122 @@
+// Frame::format() and as_hex()/as_rtlwmbus() against the original string building implementation:
+// byte exact output for all link modes, RSSI values and reception times, then time per frame.
+#include <cstdio>
+#include <ctime>
+#include <random>
+
+#include "esp_timer.h"
+#include "esphome/components/wmbus_radio/packet.h"
+
+#include "bench.h"
+
+using namespace esphome;
+using namespace esphome::wmbus_radio;
+
+// Formatting used before Frame::format(), kept as reference
+static std::string reference_as_hex(const std::vector<uint8_t> &data) { return format_hex(data); }
+
+static std::string reference_as_rtlwmbus(const std::vector<uint8_t> &data, LinkMode link_mode, int8_t rssi,
+                                         timeval rx_time) {
+  const size_t time_repr_size = sizeof("YYYY-MM-DD HH:MM:SS.00Z");
+  char time_buffer[time_repr_size];
+  auto length = std::strftime(time_buffer, time_repr_size, "%F %T", std::gmtime(&rx_time.tv_sec));
+  snprintf(time_buffer + length, time_repr_size - length, ".%02dZ", (int) (rx_time.tv_usec / 10000));
+
+  auto output = std::string{};
+  output.reserve(2 + 5 + 24 + 1 + 4 + 5 + 2 * data.size() + 1);
+
+  output += linkModeName(link_mode);  // size 2
+  output += ";1;1;";                  // size 5
+  output += time_buffer;              // size 24
+  output += ';';                      // size 1
+  output += std::to_string(rssi);     // size up to 4
+  output += ";;;0x";                  // size 5
+  output += reference_as_hex(data);   // size 2 * frame.size()
+  output += "\n";                     // size 1
+  return output;
+}
+
+static const LinkMode LINK_MODES[] = {
+#define X(name, lcname, option, val) LinkMode::name,
+    LIST_OF_LINK_MODES
+#undef X
+};
+
+static size_t failed = 0;
+
+static void expect_equal(const std::string &what, const std::string &expected, const std::string &actual) {
+  if (expected != actual) {
+    std::printf("%s mismatch:\n  reference: %s  format:    %s", what.c_str(), expected.c_str(), actual.c_str());
+    failed++;
+  }
+}
+
+// Reception time is derived from wall clock on every call, so frames are made received in the middle
+// of a centisecond: time read by the reference and by formatting then always prints the same
+static Frame make_frame(std::vector<uint8_t> data, LinkMode link_mode, int8_t rssi, int64_t age_us) {
+  auto rx_timestamp_us = esp_timer_get_time() - age_us;
+  auto probe = Frame(data, link_mode, BlockType::A, rssi, rx_timestamp_us);
+  auto shift_us = 5000 - probe.rx_time().tv_usec % 10000;
+  return Frame(std::move(data), link_mode, BlockType::A, rssi, rx_timestamp_us + shift_us);
+}
+
+static void check_rtlwmbus(Frame &frame) {
+  auto expected = reference_as_rtlwmbus(frame.data(), frame.link_mode(), frame.rssi(), frame.rx_time());
+  expect_equal("as_rtlwmbus", expected, frame.as_rtlwmbus());
+  std::vector<char> buffer(frame.formatted_size(Frame::RTLWMBUS));
+  expect_equal("format(RTLWMBUS)", expected,
+               std::string(buffer.data(), frame.format(Frame::RTLWMBUS, buffer.data(), buffer.size())));
+}
+
+int main(int argc, char **argv) {
+  parse_bench_args(argc, argv);
+  std::mt19937 rng(1);
+  auto random_data = [&](size_t size) {
+    std::vector<uint8_t> data(size);
+    for (auto &byte : data)
+      byte = rng();
+    return data;
+  };
+
+  size_t checked = 0;
+  // Every link mode and RSSI value, frames of all sizes
+  for (auto link_mode : LINK_MODES)
+    for (int rssi = -128; rssi < 128; rssi++, checked++) {
+      auto frame = make_frame(random_data(rng() % 256), link_mode, rssi, 0);
+      check_rtlwmbus(frame);
+      expect_equal("as_hex", reference_as_hex(frame.data()), frame.as_hex());
+    }
+
+  // Reception times in the past, from microseconds to days, so cached date and time part is renewed
+  for (int i = 0; i < 20000; i++, checked++) {
+    int64_t age_us = rng() % 2 ? rng() % 2000000 : int64_t(rng()) * (rng() % 64);
+    auto frame = make_frame(random_data(31), LinkMode::T1, -70, age_us);
+    check_rtlwmbus(frame);
+  }
+  std::printf("Compared %zu formatted frames with reference, %zu mismatches\n", checked, failed);
+
+  std::printf("Frame bytes  rtlwmbus: reference  as_rtlwmbus  format   hex: reference  as_hex  format\n");
+  for (size_t size : {31, 100, 290}) {
+    auto frame = make_frame(random_data(size), LinkMode::C1, -85, 0);
+    std::vector<char> buffer(frame.formatted_size(Frame::RTLWMBUS));
+
+    auto reference_rtl_ns = measure_ns([&]() {
+      do_not_optimize(reference_as_rtlwmbus(frame.data(), frame.link_mode(), frame.rssi(), frame.rx_time()));
+    });
+    auto rtl_ns = measure_ns([&]() { do_not_optimize(frame.as_rtlwmbus()); });
+    auto rtl_buffer_ns = measure_ns([&]() {
+      do_not_optimize(frame.format(Frame::RTLWMBUS, buffer.data(), buffer.size()));
+      do_not_optimize(buffer);
+    });
+    auto reference_hex_ns = measure_ns([&]() { do_not_optimize(reference_as_hex(frame.data())); });
+    auto hex_ns = measure_ns([&]() { do_not_optimize(frame.as_hex()); });
+    auto hex_buffer_ns = measure_ns([&]() {
+      do_not_optimize(frame.format(Frame::HEX, buffer.data(), buffer.size()));
+      do_not_optimize(buffer);
+    });
+    std::printf("%11zu  %16.0f ns  %8.0f ns  %3.0f ns  %11.0f ns  %3.0f ns  %3.0f ns\n", size, reference_rtl_ns,
+                rtl_ns, rtl_buffer_ns, reference_hex_ns, hex_ns, hex_buffer_ns);
+  }
+
+  return failed ? 1 : 0;
+}
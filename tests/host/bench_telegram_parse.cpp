@@ -0,0 +1,54 @@
+// Time of parsing multi-record heat meter telegrams from driver tests by their meters
+// (data record parsing and field extraction), and with JSON printing on top.
+// Built against components of another checkout (see CMakeLists.txt) it gives numbers to compare with.
+#include <cstdio>
+#include <set>
+#include <string>
+
+#include "bench.h"
+#include "driver_tests.h"
+
+static const std::set<std::string> HEAT_METER_DRIVERS = {
+    "c5isf", "compact5", "enercal", "hydrocalm3", "microclima", "pollucomf", "qheat", "sharky", "sharky774", "ultraheat",
+};
+
+int main(int argc, char **argv) {
+  parse_bench_args(argc, argv);
+
+  size_t telegrams = 0;
+  double parse_total_ns = 0, print_total_ns = 0;
+  std::printf("%-14s %-10s %5s %7s %10s %14s\n", "Driver", "Test", "Bytes", "Records", "Parse", "Parse + JSON");
+  for (auto &test : load_driver_test_telegrams()) {
+    if (!HEAT_METER_DRIVERS.count(test.driver))
+      continue;
+    auto meter = create_test_meter(test);
+    if (!meter)
+      continue;
+
+    AboutTelegram about("host", -70, LinkMode::T1, FrameType::WMBUS, 1700000000);
+    std::vector<Address> addresses;
+    bool id_match = false;
+    Telegram telegram;
+    meter->handleTelegram(about, test.telegram, false, &addresses, &id_match, &telegram);
+    if (!id_match)
+      continue;
+
+    auto parse_ns = measure_ns([&]() {
+      Telegram t;
+      addresses.clear();
+      meter->handleTelegram(about, test.telegram, false, &addresses, &id_match, &t);
+      do_not_optimize(t);
+    });
+    auto print_ns = measure_ns([&]() { do_not_optimize(handle_test_telegram(meter.get(), test)); });
+
+    std::printf("%-14s %-10s %5zu %7zu %7.1f us %11.1f us\n", test.driver.c_str(), test.name.c_str(),
+                test.telegram.size(), telegram.dv_entries.size(), parse_ns / 1000, print_ns / 1000);
+    telegrams++;
+    parse_total_ns += parse_ns;
+    print_total_ns += print_ns;
+  }
+  if (telegrams)
+    std::printf("Average of %zu telegrams: parse %.1f us, parse + JSON %.1f us\n", telegrams,
+                parse_total_ns / telegrams / 1000, print_total_ns / telegrams / 1000);
+  return telegrams ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "esphome/components/wmbus_common/util.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+static const uint8_t ENCODE_TABLE[16] = {
+    0b010110, 0b001101, 0b001110, 0b001011, 0b011100, 0b011001, 0b011010, 0b010011,
+    0b101100, 0b100101, 0b100110, 0b100011, 0b110100, 0b110001, 0b110010, 0b101001,
+};
+
+static void append_block(std::vector<uint8_t> &out, const uint8_t *data, size_t size) {
+  out.insert(out.end(), data, data + size);
+  auto crc = crc16_EN13757(&out[out.size() - size], size);
+  out.push_back(crc >> 8);
+  out.push_back(crc & 0xFF);
+}
+
+std::vector<uint8_t> add_dll_crcs(const std::vector<uint8_t> &telegram, BlockType block_type) {
+  std::vector<uint8_t> in = telegram;
+  std::vector<uint8_t> out;
+
+  if (block_type == BlockType::B) {
+    // L-field counts CRCs: one for the first 126 bytes (L included), one for the rest if any
+    size_t crcs = in.size() > 126 ? 2 : 1;
+    in[0] = in.size() + 2 * crcs - 1;
+    auto first = std::min<size_t>(in.size(), 126);
+    append_block(out, in.data(), first);
+    if (in.size() > first)
+      append_block(out, in.data() + first, in.size() - first);
+    return out;
+  }
+
+  // Format A: 10 bytes in the first block, 16 in the next ones, L-field without CRCs
+  in[0] = in.size() - 1;
+  append_block(out, in.data(), 10);
+  for (size_t pos = 10; pos < in.size(); pos += 16)
+    append_block(out, in.data() + pos, std::min<size_t>(16, in.size() - pos));
+  return out;
+}
+
+std::vector<uint8_t> encode3of6(const std::vector<uint8_t> &data) {
+  std::vector<uint8_t> out;
+  uint32_t bits = 0;
+  size_t bit_count = 0;
+  for (auto byte : data) {
+    bits = (bits << 12) | (ENCODE_TABLE[byte >> 4] << 6) | ENCODE_TABLE[byte & 0x0F];
+    bit_count += 12;
+    while (bit_count >= 8) {
+      bit_count -= 8;
+      out.push_back(bits >> bit_count);
+    }
+  }
+  if (bit_count)
+    out.push_back(bits << (8 - bit_count));
+  return out;
+}
+
+Capture make_capture(const std::vector<uint8_t> &telegram, LinkMode link_mode, BlockType block_type) {
+  Capture capture{link_mode, block_type, {}, telegram};
+  auto frame = add_dll_crcs(telegram, block_type);
+  switch (link_mode) {
+    case LinkMode::T1:
+      capture.raw = encode3of6(frame);
+      break;
+    case LinkMode::C1:
+      capture.raw = {0x54, uint8_t(block_type == BlockType::B ? 0x3D : 0xCD)};
+      capture.raw.insert(capture.raw.end(), frame.begin(), frame.end());
+      break;
+    default:
+      capture.raw = frame;
+      break;
+  }
+  return capture;
+}
+
+Capture make_noise(std::mt19937 &rng, size_t size) {
+  Capture capture{LinkMode::UNKNOWN, BlockType::UNKNOWN, {}, {}};
+  capture.raw.resize(size);
+  for (auto &byte : capture.raw)
+    byte = rng();
+  return capture;
+}
+
+bool receive_capture(Packet &packet, const Capture &capture) {
+  packet.reset(capture.link_mode == LinkMode::S1 ? LinkMode::S1 : LinkMode::UNKNOWN);
+  packet.set_rssi(capture.rssi);
+  size_t pos = 0;
+  auto feed = [&]() {
+    auto ptr = packet.rx_data_ptr();
+    auto size = packet.rx_capacity();
+    if (pos + size > capture.raw.size())
+      return false;
+    std::memcpy(ptr, capture.raw.data() + pos, size);
+    pos += size;
+    return true;
+  };
+  if (!feed() || !packet.validate_preamble() || !packet.calculate_payload_size())
+    return false;
+  while (!packet.is_complete())
+    if (!feed() || !packet.verify_block())
+      return false;
+  return true;
+}
+
+std::vector<Capture> load_capture_file(const std::string &path) {
+  std::ifstream in(path);
+  if (!in)
+    throw std::runtime_error("Cannot open " + path);
+  std::vector<Capture> result;
+  std::string line;
+  while (std::getline(in, line)) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream words(line);
+    std::string mode, hex;
+    if (!(words >> mode >> hex))
+      continue;
+    Capture capture{LinkMode::UNKNOWN, BlockType::UNKNOWN, {}, {}};
+    if (!hex2bin(hex, &capture.raw))
+      throw std::runtime_error("Invalid capture: " + line);
+    if (mode == "T1") {
+      capture.link_mode = LinkMode::T1;
+      capture.block_type = BlockType::A;
+    } else if (mode == "C1a" || mode == "C1b") {
+      capture.link_mode = LinkMode::C1;
+      capture.block_type = mode == "C1a" ? BlockType::A : BlockType::B;
+    } else if (mode == "S1") {
+      capture.link_mode = LinkMode::S1;
+      capture.block_type = BlockType::A;
+    }
+    result.push_back(std::move(capture));
+  }
+  return result;
+}
+
+}  // namespace wmbus_radio
+}  // namespace esphome
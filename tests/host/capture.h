@@ -0,0 +1,41 @@
+#pragma once
+// Building blocks for replaying radio traffic on host: turns CRC-less telegrams (as printed by wmbusmeters
+// and kept in driver tests) into byte streams the transceiver delivers after sync word.
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "esphome/components/wmbus_radio/packet.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+struct Capture {
+  LinkMode link_mode;
+  BlockType block_type;
+  // Bytes following sync word, as read from transceiver FIFO
+  std::vector<uint8_t> raw;
+  // Telegram without CRCs the capture was made of, empty for noise
+  std::vector<uint8_t> telegram;
+  int8_t rssi{-70};
+};
+
+// Inserts DLL CRCs and fixes L-field for given frame format
+std::vector<uint8_t> add_dll_crcs(const std::vector<uint8_t> &telegram, BlockType block_type);
+// Reference 3 out of 6 encoder, odd byte count is padded to whole bytes with zero bits
+std::vector<uint8_t> encode3of6(const std::vector<uint8_t> &data);
+// T1 is always format A, C1 is A or B
+Capture make_capture(const std::vector<uint8_t> &telegram, LinkMode link_mode, BlockType block_type);
+// Random bytes, as received when sync word was matched by noise
+Capture make_noise(std::mt19937 &rng, size_t size);
+
+// Feeds capture to packet in chunks requested by it, like receiver task does (without radio timing)
+// Returns true if all blocks were received and verified
+bool receive_capture(Packet &packet, const Capture &capture);
+
+// Capture file: one capture per line "<T1|C1a|C1b|S1> <hex bytes after sync word>", '#' starts a comment
+std::vector<Capture> load_capture_file(const std::string &path);
+
+}  // namespace wmbus_radio
+}  // namespace esphome
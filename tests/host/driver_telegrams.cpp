@@ -0,0 +1,84 @@
+// Feeds telegrams of all driver tests to their meters and compares printed JSON with output recorded
+// in driver_telegrams.expected, which was made by the meter code before its optimizations (baseline tree).
+// Each test gets its own meter, its telegrams go in order as some fields depend on previous ones.
+//
+//   driver_telegrams [--expected FILE] [--write]
+//
+// --write records current output instead of comparing
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "driver_tests.h"
+
+int main(int argc, char **argv) {
+  std::string expected_path = EXPECTED_DIR "/driver_telegrams.expected";
+  bool write = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--expected") == 0 && i + 1 < argc)
+      expected_path = argv[++i];
+    else if (std::strcmp(argv[i], "--write") == 0)
+      write = true;
+    else {
+      std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+      return 2;
+    }
+  }
+
+  // "<driver file> <test number in file> <test name> <telegram number in test>" -> JSON,
+  // empty if meter did not accept telegram (test names are not unique)
+  std::vector<std::pair<std::string, std::string>> results;
+  std::map<size_t, std::shared_ptr<Meter>> meters;
+  std::map<size_t, size_t> telegram_counts;
+  std::map<std::string, size_t> first_test_of_file;
+  for (auto &test : load_driver_test_telegrams()) {
+    auto &meter = meters[test.test_index];
+    if (!meter)
+      meter = create_test_meter(test);
+    auto first_test = first_test_of_file.emplace(test.driver_file, test.test_index).first->second;
+    auto key = test.driver_file + " " + std::to_string(test.test_index - first_test) + " " + test.name + " " +
+               std::to_string(telegram_counts[test.test_index]++);
+    results.emplace_back(key, meter ? handle_test_telegram(meter.get(), test) : "no meter");
+  }
+
+  if (write) {
+    std::ofstream out(expected_path);
+    for (auto &result : results)
+      out << result.first << '\t' << result.second << '\n';
+    std::printf("Recorded %zu telegrams to %s\n", results.size(), expected_path.c_str());
+    return out ? 0 : 1;
+  }
+
+  std::map<std::string, std::string> expected;
+  std::ifstream in(expected_path);
+  if (!in) {
+    std::printf("Cannot open %s\n", expected_path.c_str());
+    return 1;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    auto tab = line.find('\t');
+    expected[line.substr(0, tab)] = tab == std::string::npos ? "" : line.substr(tab + 1);
+  }
+
+  size_t failed = 0;
+  for (auto &result : results) {
+    auto it = expected.find(result.first);
+    if (it == expected.end()) {
+      std::printf("%s: no expected output\n", result.first.c_str());
+      failed++;
+    } else if (it->second != result.second) {
+      std::printf("%s: output differs\n  expected: %s\n  actual:   %s\n", result.first.c_str(), it->second.c_str(),
+                  result.second.c_str());
+      failed++;
+    }
+  }
+  if (expected.size() != results.size()) {
+    std::printf("%zu telegrams expected, %zu found in driver tests\n", expected.size(), results.size());
+    failed++;
+  }
+  std::printf("Compared JSON of %zu telegrams, %zu differences\n", results.size(), failed);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+#include "driver_tests.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <dirent.h>
+
+static std::vector<std::string> driver_sources(const std::string &dir) {
+  std::vector<std::string> files;
+  auto d = opendir(dir.c_str());
+  if (d == nullptr)
+    throw std::runtime_error("Cannot open " + dir);
+  while (auto entry = readdir(d)) {
+    std::string name = entry->d_name;
+    if (name.rfind("driver_", 0) == 0 && name.size() > 4 && name.compare(name.size() - 4, 4, ".cpp") == 0)
+      files.push_back(name);
+  }
+  closedir(d);
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+std::vector<DriverTestTelegram> load_driver_test_telegrams(const std::string &drivers_dir) {
+  std::vector<DriverTestTelegram> result;
+  size_t test_index = 0;
+  for (auto &file : driver_sources(drivers_dir)) {
+    std::ifstream in(drivers_dir + "/" + file);
+    std::string line;
+    DriverTestTelegram test;
+    bool in_test = false;
+    while (std::getline(in, line)) {
+      if (line.rfind("// Test:", 0) == 0) {
+        std::istringstream words(line.substr(8));
+        test = DriverTestTelegram{file};
+        words >> test.name >> test.driver >> test.id >> test.key;
+        if (test.key == "NOKEY")
+          test.key.clear();
+        test.test_index = test_index++;
+        in_test = true;
+      } else if (in_test && line.rfind("// telegram=", 0) == 0) {
+        // Either bare hex or |hex|, possibly split in more parts by | and followed by +seconds
+        auto hex = line.substr(12);
+        if (!hex.empty() && hex[0] == '|') {
+          auto end = hex.rfind('|');
+          if (end > 0)
+            hex.resize(end);
+          hex.erase(std::remove(hex.begin(), hex.end(), '|'), hex.end());
+        }
+        test.telegram.clear();
+        if (!hex2bin(hex, &test.telegram) || test.telegram.empty())
+          throw std::runtime_error("Invalid telegram in " + file + ": " + line);
+        result.push_back(test);
+      }
+    }
+  }
+  return result;
+}
+
+std::shared_ptr<Meter> create_test_meter(const DriverTestTelegram &test) {
+  MeterInfo meter_info;
+  meter_info.parse(test.name, test.driver, test.id + ',', test.key);
+  return createMeter(&meter_info);
+}
+
+std::string handle_test_telegram(Meter *meter, const DriverTestTelegram &test, time_t timestamp) {
+  AboutTelegram about("host", -70, LinkMode::T1, FrameType::WMBUS, timestamp);
+  std::vector<Address> addresses;
+  bool id_match = false;
+  Telegram telegram;
+  meter->handleTelegram(about, test.telegram, false, &addresses, &id_match, &telegram);
+  if (!id_match)
+    return {};
+
+  std::string json;
+  meter->printMeter(&telegram, nullptr, nullptr, '\t', &json, nullptr, nullptr, nullptr, false);
+  return json;
+}
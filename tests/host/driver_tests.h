@@ -0,0 +1,30 @@
+#pragma once
+// Telegrams recorded in wmbusmeters driver sources, used to feed real meters on host
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esphome/components/wmbus_common/meters.h"
+
+// Telegram found after "// Test: <name> <driver> <id> <key>" line
+struct DriverTestTelegram {
+  std::string driver_file;
+  std::string name;
+  std::string driver;
+  std::string id;
+  std::string key;
+  // Without DLL CRCs, as handleTelegram expects it
+  std::vector<uchar> telegram;
+  // Telegrams of the same test go to the same meter, one after another
+  size_t test_index;
+};
+
+// Telegrams of all driver_*.cpp files in directory, in file name order
+std::vector<DriverTestTelegram> load_driver_test_telegrams(const std::string &drivers_dir = WMBUS_COMMON_DIR);
+
+// Meter configured the way wmbus_meter component does it
+std::shared_ptr<Meter> create_test_meter(const DriverTestTelegram &test);
+
+// Returns JSON printed for the telegram, empty if meter did not accept it
+// Timestamp of reception is fixed, so output is reproducible
+std::string handle_test_telegram(Meter *meter, const DriverTestTelegram &test, time_t timestamp = 1700000000);
@@ -0,0 +1,123 @@
+// Duplicate filter: window counted from the first copy, eviction of the least recently seen entry
+// when all 16 are taken, keys made of meter ID and frame hash. Then suppressed duplicates of a meter
+// configured with the ELL/TPL address of frames, like meters behind a radio adapter.
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "esphome/components/wmbus_radio/component.h"
+#include "esphome/components/wmbus_radio/duplicate_filter.h"
+
+#include "capture.h"
+#include "driver_tests.h"
+
+using namespace esphome;
+using namespace esphome::wmbus_radio;
+
+static size_t failed = 0;
+
+static void check(const char *name, bool ok) {
+  std::printf("%-50s %s\n", name, ok ? "ok" : "FAILED");
+  failed += !ok;
+}
+
+static std::vector<uint8_t> frame(uint8_t n) { return {0x0E, 0x44, 0x2D, 0x2C, n, 0x00, 0x00, 0x00, 0x01, 0x1B}; }
+
+static const uint32_t METER = 0x12345678;
+static const uint32_t WINDOW_MS = 1000;
+
+static void check_window() {
+  DuplicateFilter filter;
+  check("Disabled filter passes copies", !filter.check(METER, frame(1), 100) && !filter.check(METER, frame(1), 101));
+
+  filter.set_window(WINDOW_MS);
+  bool first = !filter.check(METER, frame(1), 1000);
+  bool copies = filter.check(METER, frame(1), 1500) && filter.check(METER, frame(1), 1999);
+  check("Copies within window are duplicates", first && copies);
+  // Copy at 1999 did not extend the window
+  check("Copy after window passes", !filter.check(METER, frame(1), 2000));
+  check("Window restarts from that copy", filter.check(METER, frame(1), 2999) && !filter.check(METER, frame(1), 3000));
+  check("Other frame of the same meter passes", !filter.check(METER, frame(2), 3000));
+  check("Window survives millis() wrap",
+        !filter.check(METER, frame(3), 0xFFFFFF00) && filter.check(METER, frame(3), 0xFFFFFF00 + WINDOW_MS - 1));
+}
+
+static void check_keys() {
+  DuplicateFilter filter;
+  filter.set_window(WINDOW_MS);
+  // Same bytes give the same hash, only meter ID tells the entries apart
+  bool first = !filter.check(METER, frame(1), 1000) && !filter.check(METER + 1, frame(1), 1001);
+  bool copies = filter.check(METER, frame(1), 1002) && filter.check(METER + 1, frame(1), 1003);
+  check("Equal hash of other meter is not a duplicate", first);
+  check("Both equal hash entries are kept", copies);
+}
+
+static void check_eviction() {
+  DuplicateFilter filter;
+  filter.set_window(WINDOW_MS);
+  uint32_t now = 1000;
+  for (uint8_t n = 0; n < 16; n++)
+    filter.check(METER, frame(n), now++);
+
+  // Copy of frame 0 makes frame 1 the least recently seen one, frame 16 takes its entry
+  bool kept = filter.check(METER, frame(0), now++);
+  bool inserted = !filter.check(METER, frame(16), now++);
+  check("Full cache keeps entries it has seen", kept && inserted);
+  // Frame 1 comes back as new, in place of frame 2
+  check("Least recently seen entry is evicted", !filter.check(METER, frame(1), now++));
+  check("Recently seen entry survives eviction", filter.check(METER, frame(0), now++));
+  bool others_kept = true;
+  for (uint8_t n = 3; n <= 16; n++)
+    others_kept &= filter.check(METER, frame(n), now++);
+  check("Other entries are kept", others_kept && !filter.check(METER, frame(2), now++));
+}
+
+// Gives access to packet handling without receiver and processing tasks
+class TestRadio : public Radio {
+ public:
+  void init_queue() { this->packet_queue_.init(this->queue_size_); }
+  bool receive(const Capture &capture) {
+    auto packet = this->packet_queue_.producer_slot();
+    return receive_capture(*packet, capture) && this->packet_queue_.push() && this->process_packet();
+  }
+};
+
+static void check_meter_counters() {
+  // First driver test telegram with a meter ID outside of DLL address
+  for (auto &test : load_driver_test_telegrams()) {
+    auto capture = make_capture(test.telegram, LinkMode::T1, BlockType::A);
+    uint32_t meter_id = std::strtoul(test.id.c_str(), nullptr, 16);
+    Packet packet;
+    if (!receive_capture(packet, capture))
+      continue;
+    auto frame = packet.convert_to_frame();
+    if (!frame || frame->dll_id() == meter_id)
+      continue;
+
+    TestRadio radio;
+    radio.init_queue();
+    radio.set_duplicate_window(60000);
+    size_t handled = 0;
+    radio.add_frame_handler(meter_id, [&](Frame *) { handled++; });
+    for (int copy = 0; copy < 3; copy++)
+      radio.receive(capture);
+
+    std::printf("%s %s: meter %08X, DLL %08X\n", test.driver_file.c_str(), test.name.c_str(), meter_id,
+                frame->dll_id());
+    check("Meter gets the first copy only", handled == 1);
+    check("Copies are counted for meter of ELL/TPL address", radio.get_suppressed_duplicates(meter_id) == 2 &&
+                                                                 radio.get_stats().duplicate_frames == 2);
+    return;
+  }
+  check("Driver test telegram with ELL/TPL meter ID", false);
+}
+
+int main() {
+  check_window();
+  check_keys();
+  check_eviction();
+  check_meter_counters();
+
+  std::printf("%zu failed\n", failed);
+  return failed ? 1 : 0;
+}
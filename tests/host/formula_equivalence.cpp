@@ -0,0 +1,184 @@
+// Compiled formulas against the tree evaluator they replaced. Every formula of every driver (calculated
+// fields and field name templates) is calculated into every unit, with synthetic field values and with the
+// values left by the driver test telegrams. Both must give the same double bit for bit, or both nan.
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "esphome/components/wmbus_common/formula_implementation.h"
+#include "esphome/components/wmbus_common/meters.h"
+
+#include "driver_tests.h"
+
+static const Unit ALL_UNITS[] = {
+#define X(cname, lcname, hrname, quantity, explanation) Unit::cname,
+    LIST_OF_UNITS
+#undef X
+};
+
+struct MeterFormula {
+  std::string name;  // Field name, with the formula string for field name templates
+  FormulaImplementation *formula;
+};
+
+static std::vector<MeterFormula> meter_formulas(Meter *meter) {
+  std::vector<MeterFormula> formulas;
+  for (auto &fi : meter->fieldInfos()) {
+    if (fi.formula() != nullptr)
+      formulas.push_back({fi.vname(), static_cast<FormulaImplementation *>(fi.formula())});
+    auto *field_name = static_cast<StringInterpolatorImplementation *>(fi.fieldName());
+    if (field_name == nullptr)
+      continue;
+    for (auto &f : field_name->formulas_)
+      formulas.push_back({fi.vname() + " " + f->str(), static_cast<FormulaImplementation *>(f.get())});
+  }
+  return formulas;
+}
+
+// Counters of the field name templates, like storage_counter - 12 counter
+static DVEntry make_dventry(int storage, int tariff, int subunit) {
+  DVEntry dve;
+  dve.storage_nr = StorageNr(storage);
+  dve.tariff_nr = TariffNr(tariff);
+  dve.subunit_nr = SubUnitNr(subunit);
+  return dve;
+}
+
+static std::vector<DVEntry> DVENTRIES = {
+    make_dventry(0, 0, 0),
+    make_dventry(1, 2, 3),
+    make_dventry(13, 1, 0),
+    make_dventry(32, 0, 2),
+};
+
+static bool identical(double a, double b) {
+  if (std::isnan(a) && std::isnan(b))
+    return true;
+  return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+struct Checker {
+  size_t comparisons = 0;
+  size_t mismatches = 0;
+
+  // A NULL dve keeps the dventry of the previous calculation, like FieldInfo::performCalculation does
+  void compare(const std::string &where, const MeterFormula &mf, Meter *meter, Unit to, DVEntry *dve) {
+    double compiled = mf.formula->calculate(to, dve, meter);
+    double tree = mf.formula->calculateTree(to, dve, meter);
+    comparisons++;
+    if (identical(compiled, tree))
+      return;
+    if (mismatches++ < 20)
+      std::printf("%s %s (%s) to %s: compiled %.17g tree %.17g\n", where.c_str(), mf.name.c_str(),
+                  mf.formula->tree().c_str(), unitToStringLowerCase(to).c_str(), compiled, tree);
+  }
+
+  void compare_all_dventries(const std::string &where, const MeterFormula &mf, Meter *meter, Unit to) {
+    for (auto &dve : DVENTRIES)
+      compare(where, mf, meter, to, &dve);
+  }
+};
+
+static std::shared_ptr<Meter> create_meter(const std::string &driver) {
+  MeterInfo meter_info;
+  meter_info.parse("formulas", driver, "12345678,", "");
+  return createMeter(&meter_info);
+}
+
+// Round 0 leaves the fields unset, round 1 sets them in their display units, later rounds in other
+// units they convert from, the last round to zero.
+static const int ROUNDS = 5;
+
+static void set_field_values(Meter *meter, int round, std::mt19937 &rng) {
+  if (round == 0)
+    return;
+  for (auto &fi : meter->fieldInfos()) {
+    Quantity quantity = fi.xuantity();
+    if (quantity == Quantity::Text)
+      continue;
+    Unit unit = fi.displayUnit();
+    if (round > 1) {
+      std::vector<Unit> units;
+      for (Unit u : ALL_UNITS)
+        if (canConvert(u, fi.displayUnit()))
+          units.push_back(u);
+      unit = units[(round + fi.index()) % units.size()];
+    }
+    double value = 0;
+    if (round < ROUNDS - 1) {
+      if (quantity == Quantity::PointInTime)
+        value = std::uniform_real_distribution<double>(1.5e9, 1.8e9)(rng);
+      else
+        value = std::uniform_real_distribution<double>(-1000, 100000)(rng);
+    }
+    meter->setNumericValue(&fi, NULL, unit, value);
+  }
+}
+
+int main() {
+  Checker checker;
+  std::mt19937 rng(1);
+
+  // Synthetic values. Each target unit gets a fresh meter, so its programs are compiled while the
+  // fields are unset and then reused as the values change.
+  size_t drivers = 0, drivers_with_formulas = 0, formulas = 0;
+  for (DriverInfo *di : allDrivers()) {
+    std::string driver = di->name().str();
+    auto meter = create_meter(driver);
+    if (!meter) {
+      std::printf("Cannot create meter for driver %s\n", driver.c_str());
+      checker.mismatches++;
+      continue;
+    }
+    drivers++;
+    if (meter_formulas(meter.get()).empty())
+      continue;
+    drivers_with_formulas++;
+    formulas += meter_formulas(meter.get()).size();
+
+    for (Unit to : ALL_UNITS) {
+      meter = create_meter(driver);
+      auto mfs = meter_formulas(meter.get());
+      for (int round = 0; round < ROUNDS; round++) {
+        set_field_values(meter.get(), round, rng);
+        for (auto &mf : mfs) {
+          checker.compare(driver, mf, meter.get(), to, NULL);
+          checker.compare_all_dventries(driver, mf, meter.get(), to);
+        }
+      }
+    }
+  }
+  std::printf("Synthetic values: %zu drivers, %zu of them with %zu formulas, %zu comparisons\n", drivers,
+              drivers_with_formulas, formulas, checker.comparisons);
+
+  // Values decoded from the driver test telegrams, the dventries of a telegram are gone after it
+  // was handled, so each calculation gets its own
+  size_t synthetic_comparisons = checker.comparisons;
+  std::map<size_t, std::shared_ptr<Meter>> meters;
+  size_t telegrams = 0;
+  for (auto &test : load_driver_test_telegrams()) {
+    auto &meter = meters[test.test_index];
+    if (!meter)
+      meter = create_test_meter(test);
+    if (!meter)
+      continue;
+    auto mfs = meter_formulas(meter.get());
+    if (mfs.empty())
+      continue;
+    handle_test_telegram(meter.get(), test);
+    telegrams++;
+    for (auto &mf : mfs)
+      for (Unit to : ALL_UNITS)
+        checker.compare_all_dventries(test.driver_file + " " + test.name, mf, meter.get(), to);
+  }
+  std::printf("Driver test telegrams: %zu telegrams, %zu comparisons\n", telegrams,
+              checker.comparisons - synthetic_comparisons);
+
+  std::printf("%zu mismatches\n", checker.mismatches);
+  return checker.mismatches || !formulas || !telegrams ? 1 : 0;
+}
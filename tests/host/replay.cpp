@@ -0,0 +1,359 @@
+// Replays radio captures through Radio, Packet and Frame at a given rate and reports throughput,
+// drops and per-stage latency. Captures are made from driver test telegrams (T1, C1 format A and B,
+// or S1 with the S1 profile) mixed with noise, or loaded from a capture file.
+//
+//   replay [--rate N] [--count N] [--noise F] [--profile T1_C1|S1] [--bitrate N] [--byte-us N] [--queue-size N]
+//          [--processing-task] [--loop-budget-us N] [--loop-interval-ms N] [--no-meters] [--address-filter]
+//          [--on-packet] [--captures FILE] [--seed N] [--check] [-v]
+//
+// --rate: captures per second, --noise: fraction of captures being random noise,
+// --profile, --bitrate: radio profile and its bitrate override, like wmbus_radio configuration,
+// --byte-us: air time of one byte, when it differs from the profile (0 for fastest replay),
+// --loop-interval-ms: main loop sleep when no high frequency loop is requested (ESPHome default 16 ms),
+// --address-filter: configure meters of every other meter ID only and reject frames of the rest early,
+// --on-packet: add on_packet handler, which gets raw packets, also those failing CRC,
+// --check: fail if a frame is lost after the receiver picked it up
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+
+#include "esp_timer.h"
+#include "esphome/components/wmbus_radio/component.h"
+
+#include "capture.h"
+#include "driver_tests.h"
+#include "replay_transceiver.h"
+
+using namespace esphome;
+using namespace esphome::wmbus_radio;
+
+struct Options {
+  double rate{100};
+  size_t count{1000};
+  double noise{0.2};
+  std::string profile{"T1_C1"};
+  uint32_t bitrate{0};
+  std::optional<uint32_t> byte_time_us;
+  size_t queue_size{3};
+  bool processing_task{false};
+  uint32_t loop_budget_us{5000};
+  uint32_t loop_interval_ms{16};
+  bool meters{true};
+  bool address_filter{false};
+  bool on_packet{false};
+  std::string captures;
+  uint32_t seed{1};
+  bool check{false};
+};
+
+static Options parse_options(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&]() -> const char * {
+      if (i + 1 >= argc) {
+        std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+        std::exit(2);
+      }
+      return argv[++i];
+    };
+    if (arg == "--rate")
+      options.rate = std::atof(value());
+    else if (arg == "--count")
+      options.count = std::atol(value());
+    else if (arg == "--noise")
+      options.noise = std::atof(value());
+    else if (arg == "--profile")
+      options.profile = value();
+    else if (arg == "--bitrate")
+      options.bitrate = std::atol(value());
+    else if (arg == "--byte-us")
+      options.byte_time_us = std::atol(value());
+    else if (arg == "--queue-size")
+      options.queue_size = std::atol(value());
+    else if (arg == "--processing-task")
+      options.processing_task = true;
+    else if (arg == "--loop-budget-us")
+      options.loop_budget_us = std::atol(value());
+    else if (arg == "--loop-interval-ms")
+      options.loop_interval_ms = std::atol(value());
+    else if (arg == "--no-meters")
+      options.meters = false;
+    else if (arg == "--address-filter")
+      options.address_filter = true;
+    else if (arg == "--on-packet")
+      options.on_packet = true;
+    else if (arg == "--captures")
+      options.captures = value();
+    else if (arg == "--seed")
+      options.seed = std::atol(value());
+    else if (arg == "--check")
+      options.check = true;
+    else if (arg == "-v")
+      host_log_level++;
+    else {
+      std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+      std::exit(2);
+    }
+  }
+  return options;
+}
+
+// Bitrate and encoding of the radio profiles in wmbus_radio/__init__.py, the only parts replay depends on
+static SX1276Profile radio_profile(const Options &options) {
+  SX1276Profile profile{};
+  if (options.profile == "T1_C1") {
+    profile.bitrate = 100000;
+  } else if (options.profile == "S1") {
+    profile.bitrate = 32768;
+    profile.packet_config = 0b01 << 5;
+  } else {
+    std::fprintf(stderr, "Unknown profile %s\n", options.profile.c_str());
+    std::exit(2);
+  }
+  if (options.bitrate)
+    profile.bitrate = options.bitrate;
+  return profile;
+}
+
+static std::vector<Capture> make_captures(const Options &options, const std::vector<DriverTestTelegram> &tests) {
+  std::mt19937 rng(options.seed);
+  std::vector<Capture> source;
+  if (!options.captures.empty())
+    source = load_capture_file(options.captures);
+  else
+    for (auto &test : tests) {
+      if (options.profile == "S1") {
+        source.push_back(make_capture(test.telegram, LinkMode::S1, BlockType::A));
+        continue;
+      }
+      source.push_back(make_capture(test.telegram, LinkMode::T1, BlockType::A));
+      source.push_back(make_capture(test.telegram, LinkMode::C1, BlockType::A));
+      source.push_back(make_capture(test.telegram, LinkMode::C1, BlockType::B));
+    }
+
+  std::uniform_real_distribution<double> noise_chance(0, 1);
+  std::uniform_int_distribution<size_t> noise_size(8, WMBUS_MAX_PACKET_SIZE);
+  std::vector<Capture> captures;
+  for (size_t i = 0; i < options.count; i++) {
+    if (source.empty() || noise_chance(rng) < options.noise)
+      captures.push_back(make_noise(rng, noise_size(rng)));
+    else
+      captures.push_back(source[i % source.size()]);
+  }
+  return captures;
+}
+
+// Runs capture through a standalone packet, gives its DLL ID if it passes CRC checks
+// and tells if it makes a valid frame
+static esphome::optional<uint32_t> receive_standalone(const Capture &capture, bool &valid_frame) {
+  static Packet packet;
+  valid_frame = false;
+  if (!receive_capture(packet, capture))
+    return {};
+  valid_frame = packet.convert_to_frame().has_value();
+  return packet.dll_id();
+}
+
+// Upper bound of bucket containing given fraction of samples
+static uint32_t percentile_us(const TimingHistogram &histogram, double fraction) {
+  uint32_t target = histogram.count() * fraction, seen = 0;
+  for (size_t i = 0; i < TimingHistogram::BUCKETS; i++) {
+    seen += histogram.bucket(i);
+    if (seen > target)
+      return std::min(TimingHistogram::bucket_limit_us(i), histogram.max_us());
+  }
+  return histogram.max_us();
+}
+
+static void print_stage(const char *name, const TimingHistogram &histogram) {
+  if (!histogram.count()) {
+    std::printf("  %-12s no samples\n", name);
+    return;
+  }
+  std::printf("  %-12s avg %7.1f us, p50 < %6u us, p99 < %6u us, max %6u us (%u samples)\n", name,
+              double(histogram.total_us()) / histogram.count(), percentile_us(histogram, 0.5),
+              percentile_us(histogram, 0.99), histogram.max_us(), histogram.count());
+}
+
+int main(int argc, char **argv) {
+  // Noise makes receiver warn all the time, -v brings warnings back
+  host_log_level = ESPHOME_LOG_LEVEL_ERROR;
+  auto options = parse_options(argc, argv);
+
+  auto tests = load_driver_test_telegrams();
+  auto captures = make_captures(options, tests);
+
+  // IDs wmbus_meter components would be configured with
+  std::set<uint32_t> meter_ids;
+  if (options.meters)
+    for (auto &test : tests)
+      meter_ids.insert(std::strtoul(test.id.c_str(), nullptr, 16));
+  if (options.address_filter) {
+    bool keep = true;
+    for (auto it = meter_ids.begin(); it != meter_ids.end(); keep = !keep)
+      it = keep ? std::next(it) : meter_ids.erase(it);
+  }
+
+  auto profile = radio_profile(options);
+  auto byte_time_us = options.byte_time_us.value_or(profile.byte_time_us());
+  ReplayTransceiver transceiver(captures, options.rate, byte_time_us, profile);
+  Radio radio;
+  radio.set_radio(&transceiver);
+  if (options.profile == "S1")
+    radio.set_link_mode(LinkMode::S1);
+  radio.set_queue_size(options.queue_size);
+  radio.set_loop_budget(options.loop_budget_us);
+  radio.set_address_filter(options.address_filter);
+  if (options.processing_task)
+    radio.set_processing_task(8192, 1);
+
+  // Every frame reaches on_frame, its latency is measured from the first radio interrupt
+  std::atomic<uint32_t> frames{0};
+  TimingHistogram end_to_end;
+  radio.add_frame_handler([&](Frame *frame) {
+    increment(frames);
+    end_to_end.add(esp_timer_get_time() - frame->rx_timestamp_us());
+  });
+
+  // Meters of all driver tests parse their telegrams, like wmbus_meter components do
+  std::map<size_t, std::shared_ptr<Meter>> meters;
+  std::set<uint32_t> configured_ids;
+  TimingHistogram to_meter;
+  if (options.meters)
+    for (auto &test : tests) {
+      if (meters.count(test.test_index) || !meter_ids.count(std::strtoul(test.id.c_str(), nullptr, 16)))
+        continue;
+      auto meter = create_test_meter(test);
+      if (!meter)
+        continue;
+      meters[test.test_index] = meter;
+      auto meter_id = std::strtoul(test.id.c_str(), nullptr, 16);
+      configured_ids.insert(meter_id);
+      radio.add_frame_handler(meter_id, [&, meter](Frame *frame) {
+        AboutTelegram about("replay", frame->rssi(), frame->link_mode(), FrameType::WMBUS, frame->rx_time().tv_sec);
+        std::vector<Address> addresses;
+        bool id_match = false;
+        Telegram telegram;
+        meter->handleTelegram(about, frame->data(), false, &addresses, &id_match, &telegram);
+        if (id_match) {
+          frame->mark_as_handled();
+          to_meter.add(esp_timer_get_time() - frame->rx_timestamp_us());
+        }
+      });
+    }
+
+  // Packets of not configured meters are rejected by address filter before they are converted to frames
+  size_t expected_frames = 0, expected_rejected = 0, noise_captures = 0;
+  for (auto &capture : captures) {
+    bool valid_frame;
+    auto dll_id = receive_standalone(capture, valid_frame);
+    if (dll_id && options.address_filter && !configured_ids.empty() && !configured_ids.count(*dll_id))
+      expected_rejected++;
+    else
+      expected_frames += valid_frame;
+    noise_captures += capture.telegram.empty();
+  }
+
+  // Raw packets of valid frames must match the captures, C mode ones without the block type mark
+  std::atomic<uint32_t> raw_packets{0}, raw_mismatches{0}, raw_only_packets{0};
+  if (options.on_packet) {
+    std::set<std::vector<uint8_t>> raws;
+    for (auto &capture : captures) {
+      raws.insert(capture.raw);
+      if (capture.link_mode == LinkMode::C1)
+        raws.emplace(capture.raw.begin() + 2, capture.raw.end());
+    }
+    radio.on_packet([&, raws](Packet *packet) {
+      increment(raw_packets);
+      if (packet->is_raw_only())
+        increment(raw_only_packets);
+      else if (!raws.count(packet->get_raw_data()))
+        increment(raw_mismatches);
+    });
+  }
+
+  radio.setup();
+  auto start_us = esp_timer_get_time();
+  transceiver.start();
+
+  // ESPHome main loop, running without delay only when requested
+  while (!transceiver.finished() || radio.get_queue_items()) {
+    radio.loop();
+    HostScheduler::instance().run_deferred();
+    if (!HighFrequencyLoopRequester::is_high_frequency())
+      delay(options.loop_interval_ms);
+  }
+  // Processing task may still be handling the last packet, automations run on main loop after it
+  delay(10);
+  radio.loop();
+  HostScheduler::instance().run_deferred();
+  auto elapsed_s = (esp_timer_get_time() - start_us) / 1e6;
+
+  auto &stats = radio.get_stats();
+  uint32_t delivered = frames;
+  std::printf("Replayed %zu captures (%zu noise) at %.0f/s, %s at %u cps, %u us per byte, queue size %zu, %s\n",
+              captures.size(), noise_captures, options.rate, options.profile.c_str(), profile.bitrate, byte_time_us,
+              options.queue_size, options.processing_task ? "processing task" : "main loop");
+  std::printf("Packets: %u missed (radio not listening), %u dropped (queue full), %u received, "
+              "%u skipped by automations\n",
+              transceiver.missed(), radio.get_queue_dropped(), stats.received_packets.load(),
+              radio.get_deferred_dropped());
+  std::printf("Errors: %u preamble, %u length, %u read, %u CRC, %u invalid frames\n", stats.preamble_errors.load(),
+              stats.length_errors.load(), stats.read_errors.load(), stats.crc_errors.load(),
+              stats.invalid_frames.load());
+  if (options.address_filter)
+    std::printf("Address filter: %zu meters configured, %u of %zu foreign packets rejected\n", configured_ids.size(),
+                stats.address_rejected.load(), expected_rejected);
+  std::printf("Frames: %u of %zu delivered in %.2f s, %.1f frames/s, drop rate %.2f%%, %u handled by meters, "
+              "%u unhandled\n",
+              delivered, expected_frames, elapsed_s, delivered / elapsed_s,
+              expected_frames ? 100.0 * (expected_frames - std::min<size_t>(delivered, expected_frames)) / expected_frames
+                              : 0.0,
+              stats.handled_frames.load(), stats.unhandled_frames.load());
+  if (options.on_packet)
+    std::printf("on_packet: %u packets, %u of them failing CRC, %u not matching captures\n", raw_packets.load(),
+                raw_only_packets.load(), raw_mismatches.load());
+  std::printf("Queue high watermark: %zu\n", radio.get_queue_high_watermark());
+  std::printf("Latency per stage:\n");
+  print_stage("RX restart", stats.restart_rx);
+  print_stage("SPI read", stats.spi_read);
+  print_stage("Decode", stats.decode);
+  print_stage("Handler", stats.handler);
+  print_stage("To meter", to_meter);
+  print_stage("To on_frame", end_to_end);
+
+  int result = 0;
+  // Captures starting while receiver is still busy are missed on real radio too and depend on host scheduling,
+  // anything lost after that is a pipeline bug
+  if (options.check && (delivered + transceiver.missed() < expected_frames || radio.get_queue_dropped())) {
+    std::printf("FAILED: every received valid frame was expected to be delivered\n");
+    result = 1;
+  }
+  if (options.check && options.on_packet &&
+      (raw_packets != stats.received_packets || raw_only_packets != stats.crc_errors || raw_mismatches)) {
+    std::printf("FAILED: on_packet was expected to get every received packet as it was on air\n");
+    result = 1;
+  }
+  // Every foreign packet is rejected, unless it was missed, and none gets through to on_frame
+  if (options.check && options.address_filter &&
+      (stats.address_rejected > expected_rejected ||
+       stats.address_rejected + transceiver.missed() < expected_rejected || delivered > expected_frames)) {
+    std::printf("FAILED: address filter was expected to reject all packets of not configured meters only\n");
+    result = 1;
+  }
+  // Frames are counted once after on_frame, also when it was deferred to main loop
+  if (options.check && stats.handled_frames + stats.unhandled_frames != delivered) {
+    std::printf("FAILED: every frame delivered to on_frame was expected to be counted as handled or unhandled\n");
+    result = 1;
+  }
+
+  // Radio tasks never return, so skip destruction of objects they still use
+  std::fflush(stdout);
+  std::_Exit(result);
+}
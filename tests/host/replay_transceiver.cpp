@@ -0,0 +1,118 @@
+#include "replay_transceiver.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "esp_timer.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+// Receiver gives up when no payload length was set, like SX1276 after its maximal packet length
+static constexpr size_t MAX_UNLIMITED_READ = WMBUS_MAX_PACKET_SIZE + 2;
+
+static void sleep_until_us(int64_t time_us) {
+  auto delay = time_us - esp_timer_get_time();
+  if (delay > 0)
+    std::this_thread::sleep_for(std::chrono::microseconds(delay));
+}
+
+ReplayTransceiver::ReplayTransceiver(std::vector<Capture> captures, double rate, uint32_t byte_time_us,
+                                     const SX1276Profile &profile)
+    : captures_(std::move(captures)),
+      rate_(rate),
+      byte_time_us_(byte_time_us),
+      profile_byte_time_us_(profile.byte_time_us()) {
+  this->set_irq_pin(&this->irq_pin_instance_);
+}
+
+ReplayTransceiver::~ReplayTransceiver() {
+  if (this->thread_.joinable())
+    this->thread_.join();
+}
+
+void ReplayTransceiver::start() { this->thread_ = std::thread(&ReplayTransceiver::air_thread, this); }
+
+void ReplayTransceiver::air_thread() {
+  auto start_us = esp_timer_get_time();
+  for (size_t i = 0; i < this->captures_.size(); i++) {
+    sleep_until_us(start_us + int64_t(i * 1e6 / this->rate_));
+
+    bool received;
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      received = this->listening_;
+      if (received) {
+        this->listening_ = false;
+        this->current_ = &this->captures_[i];
+        this->current_start_us_ = esp_timer_get_time();
+        this->read_pos_ = 0;
+      }
+    }
+
+    if (received)
+      this->irq_pin_instance_.fire();
+    else
+      this->missed_++;
+  }
+  // Let the last capture go off air
+  sleep_until_us(esp_timer_get_time() + MAX_UNLIMITED_READ * this->byte_time_us_);
+  this->finished_ = true;
+}
+
+void ReplayTransceiver::restart_rx() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->listening_ = true;
+  this->current_ = nullptr;
+  this->payload_length_ = 0;
+}
+
+void ReplayTransceiver::set_payload_length(size_t length) {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->payload_length_ = length;
+}
+
+int8_t ReplayTransceiver::get_rssi() {
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  return this->current_ != nullptr ? this->current_->rssi : -120;
+}
+
+bool ReplayTransceiver::read(uint8_t *buffer, size_t length) {
+  std::unique_lock<std::mutex> lock(this->mutex_);
+  if (this->current_ == nullptr)
+    return false;
+
+  auto end = this->read_pos_ + length;
+  auto limit = this->payload_length_ ? this->payload_length_ : MAX_UNLIMITED_READ;
+  if (end > limit)
+    return false;
+
+  // Wait until requested bytes are received, a chunk at a time
+  auto start_us = this->current_start_us_;
+  auto pos = this->read_pos_;
+  lock.unlock();
+  while (pos < end) {
+    auto chunk = std::min(end - pos, SX1276_FIFO_CHUNK_SIZE);
+    pos += chunk;
+    auto ready_us = start_us + int64_t(pos * this->byte_time_us_);
+    auto timeout_us = esp_timer_get_time() + sx1276_fifo_timeout_ms(this->profile_byte_time_us_, chunk) * 1000;
+    if (ready_us > timeout_us) {
+      sleep_until_us(timeout_us);
+      return false;
+    }
+    sleep_until_us(ready_us);
+  }
+  lock.lock();
+
+  // Anything after the end of capture is noise
+  auto &raw = this->current_->raw;
+  for (size_t i = 0; i < length; i++) {
+    auto pos = this->read_pos_ + i;
+    buffer[i] = pos < raw.size() ? raw[pos] : this->noise_();
+  }
+  this->read_pos_ = end;
+  return true;
+}
+
+}  // namespace wmbus_radio
+}  // namespace esphome
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "esphome/components/wmbus_radio/transceiver_sx1276.h"
+
+#include "capture.h"
+
+namespace esphome {
+namespace wmbus_radio {
+
+class ReplayIRQPin : public InternalGPIOPin {
+ public:
+  void setup() override {}
+  bool digital_read() override { return false; }
+  void digital_write(bool value) override {}
+  std::string dump_summary() const override { return "replay"; }
+  void fire() {
+    if (this->func_ != nullptr)
+      this->func_(this->arg_);
+  }
+
+ protected:
+  void attach_interrupt(void (*func)(void *), void *arg, gpio::InterruptType type) const override {
+    this->func_ = func;
+    this->arg_ = arg;
+  }
+
+  mutable void (*func_)(void *){nullptr};
+  mutable void *arg_{nullptr};
+};
+
+// Transceiver playing back captures as if they were on air
+// Captures start at fixed rate; a capture is received only if RX was (re)started before it begins,
+// otherwise it is counted as missed. Bytes become readable as they arrive, byte_time_us apart.
+// Reads wait for FIFO sized chunks and time out like SX1276 configured with given profile.
+class ReplayTransceiver : public RadioTransceiver {
+ public:
+  ReplayTransceiver(std::vector<Capture> captures, double rate, uint32_t byte_time_us, const SX1276Profile &profile);
+  ~ReplayTransceiver();
+
+  void setup() override {}
+  void restart_rx() override;
+  void set_payload_length(size_t length) override;
+  int8_t get_rssi() override;
+  const char *get_name() override { return "Replay"; }
+  bool read(uint8_t *buffer, size_t length) override;
+
+  // Put captures on air from a separate thread
+  void start();
+  bool finished() const { return this->finished_; }
+  uint32_t missed() const { return this->missed_; }
+  const std::vector<Capture> &captures() const { return this->captures_; }
+
+ protected:
+  void air_thread();
+
+  std::vector<Capture> captures_;
+  double rate_;
+  uint32_t byte_time_us_;
+  // Byte time the radio expects, FIFO read timeouts are derived from it
+  uint32_t profile_byte_time_us_;
+  ReplayIRQPin irq_pin_instance_;
+  std::thread thread_;
+
+  std::mutex mutex_;
+  bool listening_{false};
+  const Capture *current_{nullptr};
+  int64_t current_start_us_{0};
+  size_t read_pos_{0};
+  size_t payload_length_{0};
+  std::mt19937 noise_{1};
+
+  std::atomic<bool> finished_{false};
+  std::atomic<uint32_t> missed_{0};
+};
+
+}  // namespace wmbus_radio
+}  // namespace esphome
@@ -0,0 +1,6 @@
+#pragma once
+#include <cstdint>
+
+#include "esphome/core/hal.h"
+
+inline int64_t esp_timer_get_time() { return esphome::host_uptime_us(); }
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+#include "esphome/core/component.h"
+#include "esphome/core/gpio.h"
+
+namespace esphome {
+namespace spi {
+enum SPIBitOrder { BIT_ORDER_LSB_FIRST, BIT_ORDER_MSB_FIRST };
+enum SPIClockPolarity { CLOCK_POLARITY_LOW, CLOCK_POLARITY_HIGH };
+enum SPIClockPhase { CLOCK_PHASE_LEADING, CLOCK_PHASE_TRAILING };
+enum SPIDataRate : uint32_t {
+  DATA_RATE_1MHZ = 1000000,
+  DATA_RATE_2MHZ = 2000000,
+  DATA_RATE_8MHZ = 8000000,
+};
+
+class SPIDelegate {
+ public:
+  virtual ~SPIDelegate() = default;
+  virtual void begin_transaction() {}
+  virtual void end_transaction() {}
+  virtual uint8_t transfer(uint8_t data) { return 0; }
+  virtual void read_array(uint8_t *ptr, size_t length) {
+    for (size_t i = 0; i < length; i++)
+      ptr[i] = this->transfer(0);
+  }
+};
+
+template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE, SPIDataRate DATA_RATE>
+class SPIDevice {
+ public:
+  void spi_setup() {}
+  void spi_teardown() {}
+
+ protected:
+  SPIDelegate *delegate_{nullptr};
+};
+}  // namespace spi
+}  // namespace esphome
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+// Functions deferred by components, run from host main loop with run_deferred()
+class HostScheduler {
+ public:
+  static HostScheduler &instance() {
+    static HostScheduler scheduler;
+    return scheduler;
+  }
+  void defer(std::function<void()> &&f) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->queue_.push_back(std::move(f));
+  }
+  // Returns number of executed functions
+  size_t run_deferred() {
+    size_t count = 0;
+    while (true) {
+      std::function<void()> f;
+      {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if (this->queue_.empty())
+          return count;
+        f = std::move(this->queue_.front());
+        this->queue_.pop_front();
+      }
+      f();
+      count++;
+    }
+  }
+
+ protected:
+  std::mutex mutex_;
+  std::deque<std::function<void()>> queue_;
+};
+
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+
+ protected:
+  void defer(std::function<void()> &&f) { HostScheduler::instance().defer(std::move(f)); }
+
+  bool failed_{false};
+};
+
+// Main loop runs without delay while any component requests it
+class HighFrequencyLoopRequester {
+ public:
+  void start() {
+    if (!this->started_.exchange(true))
+      num_requests()++;
+  }
+  void stop() {
+    if (this->started_.exchange(false))
+      num_requests()--;
+  }
+  static bool is_high_frequency() { return num_requests() > 0; }
+
+ protected:
+  static std::atomic<int> &num_requests() {
+    static std::atomic<int> requests{0};
+    return requests;
+  }
+  std::atomic<bool> started_{false};
+};
+}  // namespace esphome
@@ -0,0 +1,4 @@
+#pragma once
+#ifndef WMBUSMETERS_TAG
+#define WMBUSMETERS_TAG "host"
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#define IRAM_ATTR
+
+namespace esphome {
+inline uint64_t host_uptime_us() {
+  static const auto START = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START).count();
+}
+
+inline uint32_t micros() { return host_uptime_us(); }
+inline uint32_t millis() { return host_uptime_us() / 1000; }
+inline void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+}  // namespace esphome
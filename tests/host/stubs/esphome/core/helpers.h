@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include "esphome/core/optional.h"
+
+namespace esphome {
+template<typename... X> class CallbackManager;
+
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+  void call(Ts... args) {
+    for (auto &cb : this->callbacks_)
+      cb(args...);
+  }
+  size_t size() const { return this->callbacks_.size(); }
+  void operator()(Ts... args) { this->call(args...); }
+
+ protected:
+  std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+class Mutex {
+ public:
+  void lock() { this->mutex_.lock(); }
+  void unlock() { this->mutex_.unlock(); }
+
+ protected:
+  std::mutex mutex_;
+};
+
+class LockGuard {
+ public:
+  LockGuard(Mutex &mutex) : mutex_(mutex) { mutex_.lock(); }
+  ~LockGuard() { mutex_.unlock(); }
+
+ protected:
+  Mutex &mutex_;
+};
+
+inline std::string format_hex(const uint8_t *data, size_t length) {
+  static const char NIBBLES[] = "0123456789abcdef";
+  std::string ret;
+  ret.resize(length * 2);
+  for (size_t i = 0; i < length; i++) {
+    ret[2 * i] = NIBBLES[data[i] >> 4];
+    ret[2 * i + 1] = NIBBLES[data[i] & 0x0F];
+  }
+  return ret;
+}
+inline std::string format_hex(const std::vector<uint8_t> &data) { return format_hex(data.data(), data.size()); }
+
+inline std::string format_hex_pretty(const uint8_t *data, size_t length) {
+  static const char NIBBLES[] = "0123456789ABCDEF";
+  std::string ret;
+  for (size_t i = 0; i < length; i++) {
+    if (i)
+      ret += '.';
+    ret += NIBBLES[data[i] >> 4];
+    ret += NIBBLES[data[i] & 0x0F];
+  }
+  if (length > 4)
+    ret += " (" + std::to_string(length) + ")";
+  return ret;
+}
+inline std::string format_hex_pretty(const std::vector<uint8_t> &data) {
+  return format_hex_pretty(data.data(), data.size());
+}
+}  // namespace esphome
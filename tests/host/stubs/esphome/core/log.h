@@ -0,0 +1,43 @@
+#pragma once
+// Host replacement of ESPHome logger: printf to stderr, filtered at runtime by host_log_level
+#include <cstdarg>
+#include <cstdio>
+
+#define ESPHOME_LOG_LEVEL_NONE 0
+#define ESPHOME_LOG_LEVEL_ERROR 1
+#define ESPHOME_LOG_LEVEL_WARN 2
+#define ESPHOME_LOG_LEVEL_INFO 3
+#define ESPHOME_LOG_LEVEL_CONFIG 4
+#define ESPHOME_LOG_LEVEL_DEBUG 5
+#define ESPHOME_LOG_LEVEL_VERBOSE 6
+#define ESPHOME_LOG_LEVEL_VERY_VERBOSE 7
+
+namespace esphome {
+inline int host_log_level = ESPHOME_LOG_LEVEL_WARN;
+
+__attribute__((format(printf, 4, 5))) inline void host_log(int level, const char *letter, const char *tag,
+                                                           const char *format, ...) {
+  if (host_log_level < level)
+    return;
+  va_list args;
+  va_start(args, format);
+  std::fprintf(stderr, "[%s][%s] ", letter, tag);
+  std::vfprintf(stderr, format, args);
+  std::fputc('\n', stderr);
+  va_end(args);
+}
+}  // namespace esphome
+
+#define ESPHOME_HOST_LOG(level, letter, tag, ...) esphome::host_log(level, letter, tag, __VA_ARGS__)
+
+#define ESP_LOGE(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_ERROR, "E", tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_WARN, "W", tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_INFO, "I", tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_CONFIG, "C", tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_DEBUG, "D", tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_VERBOSE, "V", tag, __VA_ARGS__)
+#define ESP_LOGVV(tag, ...) ESPHOME_HOST_LOG(ESPHOME_LOG_LEVEL_VERY_VERBOSE, "VV", tag, __VA_ARGS__)
+
+#define LOG_PIN(prefix, pin) \
+  if ((pin) != nullptr) \
+    ESP_LOGCONFIG(TAG, prefix "%s", (pin)->dump_summary().c_str());
@@ -0,0 +1,30 @@
+#pragma once
+// Host replacement of the FreeRTOS task API used by components: tasks are detached std::threads
+// and direct-to-task notifications are counting semaphores. One tick is one millisecond.
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define portMAX_DELAY ((TickType_t) 0xFFFFFFFF)
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define portYIELD_FROM_ISR(x) ((void) (x))
+
+struct HostTask {
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint32_t notifications{0};
+};
+typedef HostTask *TaskHandle_t;
+
+inline thread_local HostTask *host_current_task = nullptr;
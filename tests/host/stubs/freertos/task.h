@@ -0,0 +1,51 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size, void *arg,
+                                          UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+  auto task = new HostTask();
+  if (handle != nullptr)
+    *handle = task;
+  std::thread([task, function, arg]() {
+    host_current_task = task;
+    function(arg);
+  }).detach();
+  return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_size, void *arg,
+                              UBaseType_t priority, TaskHandle_t *handle) {
+  return xTaskCreatePinnedToCore(function, name, stack_size, arg, priority, handle, tskNO_AFFINITY);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return host_current_task; }
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  auto task = host_current_task;
+  std::unique_lock<std::mutex> lock(task->mutex);
+  auto ready = [task]() { return task->notifications > 0; };
+  if (ticks == portMAX_DELAY)
+    task->cv.wait(lock, ready);
+  else if (!task->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready))
+    return 0;
+  auto value = task->notifications;
+  task->notifications = clear_on_exit ? 0 : value - 1;
+  return value;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notifications++;
+  }
+  task->cv.notify_one();
+  return pdPASS;
+}
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken) {
+  xTaskNotifyGive(task);
+  if (higher_priority_task_woken != nullptr)
+    *higher_priority_task_woken = pdFALSE;
+}
+
+inline void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }